@@ -42,6 +42,7 @@
 #include "DFGOSREntry.h"
 #include "Debugger.h"
 #include "ExceptionHelpers.h"
+#include "ExecutableAllocator.h"
 #include "GetterSetter.h"
 #include "Heap.h"
 #include <wtf/InlineASM.h>
@@ -69,7 +70,17 @@
 #include "SamplingTool.h"
 #include "Strong.h"
 #include "StructureRareDataInlines.h"
+#include "Weak.h"
+#include <wtf/CurrentTime.h>
+#include <wtf/DataLog.h>
+#include <wtf/HashMap.h>
+#include <wtf/HashSet.h>
+#include <wtf/OwnPtr.h>
 #include <wtf/StdLibExtras.h>
+#include <wtf/StringPrintStream.h>
+#include <wtf/ThreadSpecific.h>
+#include <wtf/Threading.h>
+#include <wtf/text/StringBuilder.h>
 #include <stdarg.h>
 #include <stdio.h>
 
@@ -835,6 +846,886 @@ void performPlatformSpecificJITAssertions(JSGlobalData* globalData)
 #endif
 }
 
+// Counts how often the stubs reach some caching decision; jsc dumps the totals at exit.
+#if ENABLE(SAMPLING_COUNTERS)
+#define COUNT_STUB_EVENTS(name, amount) do { \
+        DEFINE_STATIC_LOCAL(SamplingCounter, stubEventCounter, (name)); \
+        stubEventCounter.count(amount); \
+    } while (0)
+#else
+#define COUNT_STUB_EVENTS(name, amount) do { } while (0)
+#endif
+#define COUNT_STUB_EVENT(name) COUNT_STUB_EVENTS(name, 1)
+
+static bool prototypeChainIsUnchanged(Structure* structure, StructureChain* chain)
+{
+    JSValue prototype = structure->storedPrototype();
+    for (WriteBarrier<Structure>* it = chain->head(); *it; ++it) {
+        if (!prototype.isObject() || asObject(prototype)->structure() != it->get())
+            return false;
+        prototype = it->get()->storedPrototype();
+    }
+    return true;
+}
+
+// Shapes seen by a put_by_id site after the structure patched into its hot path. Sites may be
+// recycled once their CodeBlock dies, so every entry carries everything needed to validate it
+// on its own; the entries do not keep their structures alive.
+class PolymorphicPutByIdList {
+    WTF_MAKE_NONCOPYABLE(PolymorphicPutByIdList); WTF_MAKE_FAST_ALLOCATED;
+public:
+    PolymorphicPutByIdList()
+        : m_size(0)
+    {
+    }
+
+    bool tryPut(JSGlobalData&, JSValue baseValue, const Identifier&, JSValue, bool direct);
+    bool addReplace(Structure*, const Identifier&, PropertyOffset, bool direct);
+    bool addTransition(Structure* oldStructure, Structure* newStructure, StructureChain*, const Identifier&, PropertyOffset, bool direct);
+
+private:
+    struct Entry {
+        Weak<Structure> oldStructure;
+        Weak<Structure> newStructure;
+        Weak<StructureChain> chain;
+        StringImpl* uid;
+        PropertyOffset offset;
+        bool isTransition;
+        bool isDirect;
+    };
+
+    Entry* freeEntry();
+
+    Entry m_entries[POLYMORPHIC_LIST_CACHE_SIZE];
+    unsigned m_size;
+};
+
+bool PolymorphicPutByIdList::tryPut(JSGlobalData& globalData, JSValue baseValue, const Identifier& propertyName, JSValue value, bool direct)
+{
+    if (!baseValue.isCell())
+        return false;
+    Structure* structure = baseValue.asCell()->structure();
+
+    for (unsigned i = 0; i < m_size; ++i) {
+        Entry& entry = m_entries[i];
+        if (entry.oldStructure.get() != structure || entry.uid != propertyName.impl() || entry.isDirect != direct)
+            continue;
+
+        ASSERT(baseValue.isObject());
+        JSObject* base = asObject(baseValue);
+        if (!entry.isTransition) {
+            base->putDirect(globalData, entry.offset, value);
+            return true;
+        }
+
+        Structure* newStructure = entry.newStructure.get();
+        if (!newStructure)
+            return false;
+        // put_by_id_transition checks the prototype chain for setters.
+        if (!direct && (!entry.chain || !prototypeChainIsUnchanged(structure, entry.chain.get())))
+            return false;
+
+        ASSERT(structure->transitionWatchpointSetHasBeenInvalidated());
+        if (newStructure->outOfLineCapacity() != structure->outOfLineCapacity()) {
+            Butterfly* butterfly = base->growOutOfLineStorage(globalData, structure->outOfLineCapacity(), newStructure->outOfLineCapacity());
+            base->setButterfly(globalData, butterfly, newStructure);
+        } else
+            base->setStructure(globalData, newStructure);
+        base->putDirect(globalData, entry.offset, value);
+        return true;
+    }
+    return false;
+}
+
+PolymorphicPutByIdList::Entry* PolymorphicPutByIdList::freeEntry()
+{
+    // Reuse entries whose structures have since been collected before growing the list.
+    for (unsigned i = 0; i < m_size; ++i) {
+        if (!m_entries[i].oldStructure || (m_entries[i].isTransition && !m_entries[i].newStructure))
+            return &m_entries[i];
+    }
+    if (m_size == POLYMORPHIC_LIST_CACHE_SIZE)
+        return 0;
+    return &m_entries[m_size++];
+}
+
+bool PolymorphicPutByIdList::addReplace(Structure* structure, const Identifier& propertyName, PropertyOffset offset, bool direct)
+{
+    Entry* entry = freeEntry();
+    if (!entry)
+        return false;
+    entry->oldStructure = PassWeak<Structure>(structure);
+    entry->newStructure.clear();
+    entry->chain.clear();
+    entry->uid = propertyName.impl();
+    entry->offset = offset;
+    entry->isTransition = false;
+    entry->isDirect = direct;
+    return true;
+}
+
+bool PolymorphicPutByIdList::addTransition(Structure* oldStructure, Structure* newStructure, StructureChain* chain, const Identifier& propertyName, PropertyOffset offset, bool direct)
+{
+    Entry* entry = freeEntry();
+    if (!entry)
+        return false;
+    entry->oldStructure = PassWeak<Structure>(oldStructure);
+    entry->newStructure = PassWeak<Structure>(newStructure);
+    entry->chain = PassWeak<StructureChain>(chain);
+    entry->uid = propertyName.impl();
+    entry->offset = offset;
+    entry->isTransition = true;
+    entry->isDirect = direct;
+    return true;
+}
+
+// The polymorphic lists of one JSGlobalData's put_by_id sites, found by the site's return
+// address without taking a lock. A slot belongs to the first site that claims it until that
+// site's executable dies; a colliding site is sent to the generic stub rather than evicting it.
+// Every list entry validates itself, so a list found under a recycled address is harmless.
+class PolymorphicPutByIdListCache {
+    WTF_MAKE_NONCOPYABLE(PolymorphicPutByIdListCache); WTF_MAKE_FAST_ALLOCATED;
+public:
+    PolymorphicPutByIdListCache() { }
+
+    ALWAYS_INLINE PolymorphicPutByIdList* get(ReturnAddressPtr returnAddress)
+    {
+        Entry& entry = m_entries[indexFor(returnAddress)];
+        return entry.site == returnAddress.value() ? entry.list.get() : 0;
+    }
+
+    // Returns 0 if the slot is held by another site whose executable is still alive.
+    PolymorphicPutByIdList* ensure(ScriptExecutable* owner, ReturnAddressPtr returnAddress)
+    {
+        Entry& entry = m_entries[indexFor(returnAddress)];
+        if (entry.site == returnAddress.value() && entry.owner.get() == owner)
+            return entry.list.get();
+        if (entry.site != returnAddress.value() && entry.owner)
+            return 0;
+        entry.site = returnAddress.value();
+        entry.owner = PassWeak<ScriptExecutable>(owner);
+        entry.list = adoptPtr(new PolymorphicPutByIdList);
+        return entry.list.get();
+    }
+
+private:
+    static const unsigned cacheSize = 256;
+
+    struct Entry {
+        Entry()
+            : site(0)
+        {
+        }
+
+        void* site;
+        Weak<ScriptExecutable> owner;
+        OwnPtr<PolymorphicPutByIdList> list;
+    };
+
+    static unsigned indexFor(ReturnAddressPtr returnAddress)
+    {
+        return (reinterpret_cast<uintptr_t>(returnAddress.value()) >> 2) & (cacheSize - 1);
+    }
+
+    Entry m_entries[cacheSize];
+};
+
+// A small direct-mapped cache of get_by_id results, shared by every site in a JSGlobalData that
+// has given up on its own inline cache. Entries are keyed by (Structure*, property uid) and only
+// non-dictionary structures are cached, so a transition always yields a Structure that no longer
+// matches. Prototype hits revalidate the chain up to the holder on every lookup.
+class MegamorphicGetByIdCache {
+    WTF_MAKE_NONCOPYABLE(MegamorphicGetByIdCache); WTF_MAKE_FAST_ALLOCATED;
+public:
+    MegamorphicGetByIdCache() { }
+
+    bool tryGet(CallFrame*, JSValue baseValue, const Identifier&, JSValue& result);
+    void add(CallFrame*, JSValue baseValue, const Identifier&, const PropertySlot&);
+
+private:
+    static const unsigned cacheSize = 256;
+
+    struct Entry {
+        Weak<Structure> structure;
+        Weak<StructureChain> chain;
+        RefPtr<StringImpl> uid;
+        PropertyOffset offset;
+        size_t count;
+    };
+
+    static unsigned hash(Structure* structure, StringImpl* uid)
+    {
+        return ((reinterpret_cast<uintptr_t>(structure) >> 4) ^ uid->existingHash()) & (cacheSize - 1);
+    }
+
+    Entry m_entries[cacheSize];
+};
+
+bool MegamorphicGetByIdCache::tryGet(CallFrame* callFrame, JSValue baseValue, const Identifier& propertyName, JSValue& result)
+{
+    if (!baseValue.isCell())
+        return false;
+
+    Structure* structure = baseValue.asCell()->structure();
+    Entry& entry = m_entries[hash(structure, propertyName.impl())];
+    if (entry.structure.get() != structure || entry.uid != propertyName.impl())
+        return false;
+
+    if (!entry.count) {
+        if (!baseValue.isObject())
+            return false;
+        result = asObject(baseValue)->getDirect(entry.offset);
+        return true;
+    }
+
+    StructureChain* chain = entry.chain.get();
+    if (!chain)
+        return false;
+
+    JSObject* holder = 0;
+    JSValue prototype = structure->prototypeForLookup(callFrame);
+    WriteBarrier<Structure>* it = chain->head();
+    for (size_t i = 0; i < entry.count; ++i, ++it) {
+        if (!*it || !prototype.isObject() || asObject(prototype)->structure() != it->get())
+            return false;
+        holder = asObject(prototype);
+        prototype = holder->structure()->storedPrototype();
+    }
+
+    result = holder->getDirect(entry.offset);
+    return true;
+}
+
+void MegamorphicGetByIdCache::add(CallFrame* callFrame, JSValue baseValue, const Identifier& propertyName, const PropertySlot& slot)
+{
+    if (!baseValue.isCell() || !slot.isCacheable() || slot.cachedPropertyType() != PropertySlot::Value)
+        return;
+
+    Structure* structure = baseValue.asCell()->structure();
+    if (structure->isDictionary()
+        || structure->typeInfo().prohibitsPropertyCaching()
+        || structure->typeInfo().hasImpureGetOwnPropertySlot())
+        return;
+
+    PropertyOffset offset = slot.cachedOffset();
+    size_t count = 0;
+    if (slot.slotBase() != baseValue) {
+        count = normalizePrototypeChainForChainAccess(callFrame, baseValue, slot.slotBase(), propertyName, offset);
+        if (count == InvalidPrototypeChain)
+            return;
+    }
+
+    Entry& entry = m_entries[hash(structure, propertyName.impl())];
+    entry.structure = PassWeak<Structure>(structure);
+    entry.chain = PassWeak<StructureChain>(count ? structure->prototypeChain(callFrame) : 0);
+    entry.uid = propertyName.impl();
+    entry.offset = offset;
+    entry.count = count;
+}
+
+// Caches own properties read and written through get_by_val/put_by_val with a string subscript,
+// keyed by (Structure*, StringImpl*). Keys compare by pointer, so a hit never hashes the
+// subscript; code like map[name] with a handful of names keeps hitting the same entries.
+class ByValStringCache {
+    WTF_MAKE_NONCOPYABLE(ByValStringCache); WTF_MAKE_FAST_ALLOCATED;
+public:
+    ByValStringCache() { }
+
+    ALWAYS_INLINE bool tryGet(JSCell* base, StringImpl* uid, JSValue& result)
+    {
+        Entry& entry = m_entries[hash(base->structure(), uid)];
+        if (!entry.canGet || entry.uid != uid || entry.structure.get() != base->structure())
+            return false;
+        result = asObject(base)->getDirect(entry.offset);
+        return true;
+    }
+
+    ALWAYS_INLINE bool tryPut(JSGlobalData& globalData, JSCell* base, StringImpl* uid, JSValue value)
+    {
+        Entry& entry = m_entries[hash(base->structure(), uid)];
+        if (!entry.canPut || entry.uid != uid || entry.structure.get() != base->structure())
+            return false;
+        asObject(base)->putDirect(globalData, entry.offset, value);
+        return true;
+    }
+
+    void addGet(JSValue baseValue, StringImpl* uid, const PropertySlot& slot)
+    {
+        if (!baseValue.isObject() || !slot.isCacheable() || slot.slotBase() != baseValue || slot.cachedPropertyType() != PropertySlot::Value)
+            return;
+        Structure* structure = asObject(baseValue)->structure();
+        if (structure->typeInfo().hasImpureGetOwnPropertySlot())
+            return;
+        if (Entry* entry = entryFor(structure, uid, slot.cachedOffset()))
+            entry->canGet = true;
+    }
+
+    // For an own data property that was found without a PropertySlot, e.g. by fastGetOwnProperty.
+    void addOwnGet(JSGlobalData& globalData, JSCell* base, const String& name)
+    {
+        Structure* structure = base->structure();
+        if (!base->isObject() || structure->typeInfo().overridesGetOwnPropertySlot() || structure->hasGetterSetterProperties())
+            return;
+        PropertyOffset offset = structure->get(globalData, name);
+        if (!isValidOffset(offset))
+            return;
+        if (Entry* entry = entryFor(structure, name.impl(), offset))
+            entry->canGet = true;
+    }
+
+    void addPut(JSValue baseValue, StringImpl* uid, const PutPropertySlot& slot)
+    {
+        if (!baseValue.isObject() || !slot.isCacheable() || slot.base() != baseValue || slot.type() != PutPropertySlot::ExistingProperty)
+            return;
+        if (Entry* entry = entryFor(asObject(baseValue)->structure(), uid, slot.cachedOffset()))
+            entry->canPut = true;
+    }
+
+private:
+    static const unsigned cacheSize = 256;
+
+    struct Entry {
+        Entry()
+            : offset(invalidOffset)
+            , canGet(false)
+            , canPut(false)
+        {
+        }
+
+        Weak<Structure> structure;
+        RefPtr<StringImpl> uid;
+        PropertyOffset offset;
+        bool canGet;
+        bool canPut;
+    };
+
+    static unsigned hash(Structure* structure, StringImpl* uid)
+    {
+        return ((reinterpret_cast<uintptr_t>(structure) >> 4) ^ (reinterpret_cast<uintptr_t>(uid) >> 3)) & (cacheSize - 1);
+    }
+
+    Entry* entryFor(Structure* structure, StringImpl* uid, PropertyOffset offset)
+    {
+        if (structure->isDictionary() || structure->typeInfo().prohibitsPropertyCaching())
+            return 0;
+        Entry& entry = m_entries[hash(structure, uid)];
+        if (entry.uid != uid || entry.structure.get() != structure || entry.offset != offset) {
+            entry.structure = PassWeak<Structure>(structure);
+            entry.uid = uid;
+            entry.offset = offset;
+            entry.canGet = false;
+            entry.canPut = false;
+        }
+        return &entry;
+    }
+
+    Entry m_entries[cacheSize];
+};
+
+// Backs up the per-CodeBlock EvalCodeCache for the sources it turns away: strict code, and
+// strings of 256 characters or more. Entries are keyed by the eval string, strictness, the
+// executable doing the eval and the shape of the scope it evals in. A string is only compiled
+// for this cache the second time it is seen, so one-off evals keep going through eval() and its
+// literal parser. Executables are held strongly until their entry is evicted, least recently
+// used first, or is found to belong to an executable that has died.
+class EvalExecutableCache {
+    WTF_MAKE_NONCOPYABLE(EvalExecutableCache); WTF_MAKE_FAST_ALLOCATED;
+public:
+    EvalExecutableCache()
+        : m_clock(0)
+        , m_size(0)
+    {
+    }
+
+    static bool canCache(const String& source, JSScope* scope)
+    {
+        // Same restriction as the per-CodeBlock EvalCodeCache: code compiled under a with or
+        // catch scope cannot be reused in a different one.
+        return source.length() <= maxCacheableSourceLength && scope->isVariableObject();
+    }
+
+    // Whether the per-CodeBlock EvalCodeCache would hold this string; only the strict and the
+    // longer strings it turns away are kept here.
+    static bool evalCodeCacheMayTake(bool isStrict, const String& source)
+    {
+        return !isStrict && source.length() < evalCodeCacheMaxSourceLength;
+    }
+
+    // Returns the cached executable, or 0 after noting the miss. seenBefore tells whether the
+    // string has missed here before and is worth compiling for the cache.
+    EvalExecutable* get(ScriptExecutable* owner, bool isStrict, const String& source, JSScope* scope, bool& seenBefore)
+    {
+        unsigned hash = keyHash(owner, isStrict, source, scope);
+        Entry* entry = find(hash, owner, isStrict, source, scope);
+        if (!entry) {
+            seenBefore = false;
+            entry = victim();
+            entry->hash = hash;
+            entry->source = source.impl();
+            entry->owner = PassWeak<ScriptExecutable>(owner);
+            entry->scopeStructure = PassWeak<Structure>(scope->structure());
+            entry->executable.clear();
+            entry->isStrict = isStrict;
+        } else
+            seenBefore = true;
+        entry->lastUse = ++m_clock;
+        return entry->executable.get();
+    }
+
+    void add(JSGlobalData& globalData, ScriptExecutable* owner, bool isStrict, const String& source, JSScope* scope, EvalExecutable* executable)
+    {
+        if (Entry* entry = find(keyHash(owner, isStrict, source, scope), owner, isStrict, source, scope))
+            entry->executable.set(globalData, executable);
+    }
+
+private:
+    static const unsigned cacheSize = 64;
+    static const unsigned maxCacheableSourceLength = 4096;
+    // EvalCodeCache::maxCacheableSourceLength, which is private to EvalCodeCache.
+    static const unsigned evalCodeCacheMaxSourceLength = 256;
+
+    struct Entry {
+        Entry()
+            : hash(0)
+            , lastUse(0)
+            , isStrict(false)
+        {
+        }
+
+        unsigned hash;
+        RefPtr<StringImpl> source;
+        Weak<ScriptExecutable> owner;
+        Weak<Structure> scopeStructure;
+        Strong<EvalExecutable> executable;
+        unsigned lastUse;
+        bool isStrict;
+    };
+
+    static unsigned keyHash(ScriptExecutable* owner, bool isStrict, const String& source, JSScope* scope)
+    {
+        return source.impl()->hash() ^ PtrHash<ScriptExecutable*>::hash(owner) ^ PtrHash<Structure*>::hash(scope->structure()) ^ isStrict;
+    }
+
+    Entry* find(unsigned hash, ScriptExecutable* owner, bool isStrict, const String& source, JSScope* scope)
+    {
+        for (unsigned i = 0; i < m_size; ++i) {
+            Entry& entry = m_entries[i];
+            if (!entry.owner) {
+                entry.executable.clear();
+                continue;
+            }
+            if (entry.hash != hash || entry.isStrict != isStrict || entry.owner.get() != owner || entry.scopeStructure.get() != scope->structure())
+                continue;
+            if (entry.source != source.impl() && !equal(entry.source.get(), source.impl()))
+                continue;
+            return &entry;
+        }
+        return 0;
+    }
+
+    Entry* victim()
+    {
+        if (m_size < cacheSize)
+            return &m_entries[m_size++];
+        Entry* oldest = &m_entries[0];
+        for (unsigned i = 1; i < cacheSize; ++i) {
+            if (m_entries[i].lastUse < oldest->lastUse)
+                oldest = &m_entries[i];
+        }
+        return oldest;
+    }
+
+    Entry m_entries[cacheSize];
+    unsigned m_clock;
+    unsigned m_size;
+};
+
+// Caches the answer of `key in object` for (Structure*, atomized key). Answers that depend on
+// the prototype chain are revalidated against the chain's structures, so only objects whose
+// properties are all described by their structures take part: no dictionaries, and nothing
+// that overrides getOwnPropertySlot.
+class InCache {
+    WTF_MAKE_NONCOPYABLE(InCache); WTF_MAKE_FAST_ALLOCATED;
+public:
+    InCache() { }
+
+    ALWAYS_INLINE bool tryGet(Structure* structure, StringImpl* uid, bool& result)
+    {
+        Entry& entry = m_entries[hash(structure, uid)];
+        if (entry.uid != uid || entry.structure.get() != structure)
+            return false;
+        if (entry.dependsOnPrototypes && (!entry.chain || !prototypeChainIsUnchanged(structure, entry.chain.get())))
+            return false;
+        result = entry.result;
+        return true;
+    }
+
+    bool lookup(CallFrame*, JSObject*, const Identifier&, bool& result);
+
+private:
+    static const unsigned cacheSize = 256;
+
+    struct Entry {
+        Entry()
+            : result(false)
+            , dependsOnPrototypes(false)
+        {
+        }
+
+        Weak<Structure> structure;
+        Weak<StructureChain> chain;
+        RefPtr<StringImpl> uid;
+        bool result;
+        bool dependsOnPrototypes;
+    };
+
+    static bool isDescribedByStructure(Structure* structure)
+    {
+        return !structure->isDictionary()
+            && !structure->typeInfo().overridesGetOwnPropertySlot()
+            && !structure->typeInfo().prohibitsPropertyCaching();
+    }
+
+    static unsigned hash(Structure* structure, StringImpl* uid)
+    {
+        return ((reinterpret_cast<uintptr_t>(structure) >> 4) ^ (reinterpret_cast<uintptr_t>(uid) >> 3)) & (cacheSize - 1);
+    }
+
+    Entry m_entries[cacheSize];
+};
+
+// Answers the query from structures alone and caches the answer, or returns false if the
+// objects involved do not allow that.
+bool InCache::lookup(CallFrame* callFrame, JSObject* base, const Identifier& propertyName, bool& result)
+{
+    // Index-like names are answered by getOwnPropertySlotByIndex, not by the structure.
+    if (PropertyName(propertyName).asIndex() != PropertyName::NotAnIndex)
+        return false;
+
+    JSGlobalData& globalData = callFrame->globalData();
+    Structure* structure = base->structure();
+    if (!isDescribedByStructure(structure))
+        return false;
+
+    bool dependsOnPrototypes = false;
+    result = isValidOffset(structure->get(globalData, propertyName));
+    if (!result) {
+        dependsOnPrototypes = true;
+        for (JSValue prototype = structure->storedPrototype(); prototype.isObject(); prototype = asObject(prototype)->structure()->storedPrototype()) {
+            Structure* prototypeStructure = asObject(prototype)->structure();
+            if (!isDescribedByStructure(prototypeStructure))
+                return false;
+            if (isValidOffset(prototypeStructure->get(globalData, propertyName))) {
+                result = true;
+                break;
+            }
+        }
+    }
+
+    Entry& entry = m_entries[hash(structure, propertyName.impl())];
+    entry.structure = PassWeak<Structure>(structure);
+    entry.chain = PassWeak<StructureChain>(dependsOnPrototypes ? structure->prototypeChain(callFrame) : 0);
+    entry.uid = propertyName.impl();
+    entry.result = result;
+    entry.dependsOnPrototypes = dependsOnPrototypes;
+    return true;
+}
+
+// Dispatch for op_switch_string, built the first time a table is used. Cases are placed by a
+// perfect hash of the scrutinee's length and a pair of its characters, so finding a case costs
+// one string comparison and never hashes the whole scrutinee; an empty slot or a mismatch is
+// a definite default. Each slot holds its case's jump target, so a hit never consults the
+// table's own HashMap.
+class StringSwitchDispatch {
+    WTF_MAKE_NONCOPYABLE(StringSwitchDispatch); WTF_MAKE_FAST_ALLOCATED;
+public:
+    StringSwitchDispatch(CodeBlock*, StringJumpTable&);
+
+    // Tables are reached through a direct-mapped cache keyed by address, and an address may
+    // be reused once its CodeBlock dies. A dispatch is only trusted for the same owner and the
+    // same JIT code, which also rules out the CodeBlock having been recompiled in between.
+    bool isFor(CodeBlock* codeBlock, StringJumpTable& table) const
+    {
+        return m_table == &table
+            && m_owner.get() == codeBlock->ownerExecutable()
+            && m_codeStart == codeBlock->getJITCode().start()
+            && m_defaultTarget == table.ctiDefault.executableAddress();
+    }
+
+    // A dispatch whose owner has died, or whose table has since been rebuilt for other code,
+    // can never be used again.
+    bool isStaleFor(StringJumpTable& table) const
+    {
+        return !m_owner.get() || m_table == &table;
+    }
+
+    ALWAYS_INLINE void* targetFor(StringJumpTable& table, StringImpl* value) const
+    {
+        if (m_slots.isEmpty())
+            return table.ctiForValue(value).executableAddress();
+        const Slot& slot = m_slots[slotFor(value)];
+        if (!slot.string || !equal(slot.string.get(), value))
+            return m_defaultTarget;
+        return slot.target;
+    }
+
+private:
+    struct Slot {
+        Slot()
+            : target(0)
+        {
+        }
+
+        RefPtr<StringImpl> string;
+        void* target;
+    };
+
+    bool tryLayout(StringJumpTable&, unsigned position, unsigned multiplier, unsigned sizeLog2);
+
+    ALWAYS_INLINE unsigned slotFor(StringImpl* string) const
+    {
+        unsigned length = string->length();
+        unsigned key = length;
+        if (length) {
+            unsigned index = m_position % length;
+            key += ((*string)[index] << 8) ^ ((*string)[length - 1 - index] << 20);
+        }
+        return (key * m_multiplier) >> m_shift;
+    }
+
+    StringJumpTable* m_table;
+    Weak<ScriptExecutable> m_owner;
+    void* m_codeStart;
+    void* m_defaultTarget;
+    unsigned m_position;
+    unsigned m_multiplier;
+    unsigned m_shift;
+    Vector<Slot> m_slots;
+};
+
+StringSwitchDispatch::StringSwitchDispatch(CodeBlock* codeBlock, StringJumpTable& table)
+    : m_table(&table)
+    , m_owner(PassWeak<ScriptExecutable>(codeBlock->ownerExecutable()))
+    , m_codeStart(codeBlock->getJITCode().start())
+    , m_defaultTarget(table.ctiDefault.executableAddress())
+    , m_position(0)
+    , m_multiplier(0)
+    , m_shift(0)
+{
+    static const unsigned multipliers[] = { 0x9E3779B1, 0x85EBCA6B, 0xC2B2AE35, 0x27D4EB2F };
+    static const unsigned maxPosition = 8;
+
+    // Aim for a table 2-8x the number of cases; 256 cases fit in at most 2048 slots.
+    unsigned minSizeLog2 = 1;
+    while ((1u << minSizeLog2) < 2 * table.offsetTable.size())
+        ++minSizeLog2;
+    for (unsigned sizeLog2 = minSizeLog2; sizeLog2 <= minSizeLog2 + 2; ++sizeLog2) {
+        for (unsigned position = 0; position < maxPosition; ++position) {
+            for (size_t i = 0; i < WTF_ARRAY_LENGTH(multipliers); ++i) {
+                if (tryLayout(table, position, multipliers[i], sizeLog2))
+                    return;
+            }
+        }
+    }
+    // No layout found; targetFor() falls back to the table's HashMap.
+    m_slots.clear();
+}
+
+bool StringSwitchDispatch::tryLayout(StringJumpTable& table, unsigned position, unsigned multiplier, unsigned sizeLog2)
+{
+    m_position = position;
+    m_multiplier = multiplier;
+    m_shift = 32 - sizeLog2;
+    m_slots.clear();
+    m_slots.resize(1 << sizeLog2);
+    for (StringJumpTable::StringOffsetTable::iterator iter = table.offsetTable.begin(); iter != table.offsetTable.end(); ++iter) {
+        Slot& slot = m_slots[slotFor(iter->key.get())];
+        if (slot.string)
+            return false;
+        slot.string = iter->key.get();
+        slot.target = iter->value.ctiOffset.executableAddress();
+    }
+    return true;
+}
+
+// The dispatches of one JSGlobalData, found by table address without taking a lock. Building
+// a dispatch is far more expensive than one lookup in the table's HashMap, so a table that
+// finds both ways of its set taken by live dispatches does not evict them right away: it is
+// served from the HashMap, and may only replace a way that has not been used since the set's
+// previous miss. Hot tables that collide therefore never rebuild each other over and over.
+class StringSwitchDispatchCache {
+    WTF_MAKE_NONCOPYABLE(StringSwitchDispatchCache); WTF_MAKE_FAST_ALLOCATED;
+public:
+    StringSwitchDispatchCache() { }
+
+    ALWAYS_INLINE void* targetFor(CodeBlock* codeBlock, StringJumpTable& table, StringImpl* value)
+    {
+        Way* set = m_sets[(reinterpret_cast<uintptr_t>(&table) >> 4) & (numberOfSets - 1)];
+        for (unsigned i = 0; i < associativity; ++i) {
+            if (set[i].dispatch && set[i].dispatch->isFor(codeBlock, table)) {
+                set[i].referenced = true;
+                return set[i].dispatch->targetFor(table, value);
+            }
+        }
+        if (Way* way = wayToReplace(set, table)) {
+            way->dispatch = adoptPtr(new StringSwitchDispatch(codeBlock, table));
+            way->referenced = true;
+            return way->dispatch->targetFor(table, value);
+        }
+        COUNT_STUB_EVENT("op_switch_string dispatch cache conflicts");
+        return table.ctiForValue(value).executableAddress();
+    }
+
+private:
+    static const unsigned numberOfSets = 64;
+    static const unsigned associativity = 2;
+
+    struct Way {
+        Way()
+            : referenced(false)
+        {
+        }
+
+        OwnPtr<StringSwitchDispatch> dispatch;
+        bool referenced;
+    };
+
+    static Way* wayToReplace(Way* set, StringJumpTable& table)
+    {
+        for (unsigned i = 0; i < associativity; ++i) {
+            if (!set[i].dispatch || set[i].dispatch->isStaleFor(table))
+                return &set[i];
+        }
+        Way* result = 0;
+        for (unsigned i = 0; i < associativity; ++i) {
+            if (!set[i].referenced && !result)
+                result = &set[i];
+            set[i].referenced = false;
+        }
+        return result;
+    }
+
+    Way m_sets[numberOfSets][associativity];
+};
+
+class StubSamplingProfiler;
+
+// cti_timeout_check is how JIT code polls. The TimeoutChecker expects to be consulted only once
+// the ticks it asked for have passed, so when something needs the JIT to poll more often the
+// stub hands out shorter intervals and counts down the checker's budget on its behalf.
+struct TimeoutCheckPacing {
+    TimeoutCheckPacing()
+        : lastInterval(0)
+        , checkerTicksLeft(0)
+        , frequentCheckRequests(0)
+    {
+    }
+
+    unsigned lastInterval;
+    unsigned checkerTicksLeft;
+    unsigned frequentCheckRequests;
+};
+
+// The stub caches that are shared by everything running in one JSGlobalData. They hang off a
+// cell that lives exactly as long as the JSGlobalData.
+struct VMStubCaches {
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    PolymorphicPutByIdListCache putByIdLists;
+    MegamorphicGetByIdCache getById;
+    ByValStringCache byValString;
+    EvalExecutableCache evalCode;
+    InCache in;
+    StringSwitchDispatchCache stringSwitch;
+    TimeoutCheckPacing timeoutCheckPacing;
+    StubSamplingProfiler* samplingProfiler;
+#if ENABLE(SAMPLING_COUNTERS)
+    HashSet<pair<CodeBlock*, RegExp*> > countedRegExpLiterals;
+#endif
+
+    VMStubCaches()
+        : samplingProfiler(0)
+    {
+    }
+};
+
+// The stub caches of every JSGlobalData. Each JSGlobalData's caches are thrown away when its
+// structureStructure is finalized, which happens when its heap is torn down.
+class VMStubCacheMap {
+    WTF_MAKE_NONCOPYABLE(VMStubCacheMap);
+public:
+    static VMStubCaches* ensure(JSGlobalData& globalData)
+    {
+        VMStubCacheMap& map = shared();
+        MutexLocker locker(map.m_lock);
+        JSCell* owner = globalData.structureStructure.get();
+        CacheMap::AddResult result = map.m_caches.add(owner, nullptr);
+        if (result.isNewEntry) {
+            result.iterator->value = adoptPtr(new VMStubCaches);
+            globalData.heap.addFinalizer(owner, finalize);
+        }
+        return result.iterator->value.get();
+    }
+
+    // Bumped whenever caches are thrown away, so callers may remember a lookup until it changes.
+    // Reading it does not go through shared(), whose initialization takes a global lock.
+    static unsigned generation() { return s_generation; }
+
+private:
+    typedef HashMap<JSCell*, OwnPtr<VMStubCaches> > CacheMap;
+
+    VMStubCacheMap() { }
+
+    static VMStubCacheMap& shared()
+    {
+        AtomicallyInitializedStatic(VMStubCacheMap*, map = new VMStubCacheMap);
+        return *map;
+    }
+
+    static void finalize(JSCell* owner)
+    {
+        VMStubCacheMap& map = shared();
+        MutexLocker locker(map.m_lock);
+        map.m_caches.remove(owner);
+        ++s_generation;
+    }
+
+    Mutex m_lock;
+    CacheMap m_caches;
+
+    static unsigned s_generation;
+};
+
+unsigned VMStubCacheMap::s_generation = 0;
+
+struct LastVMStubCaches {
+    LastVMStubCaches()
+        : globalData(0)
+        , generation(0)
+        , caches(0)
+    {
+    }
+
+    JSGlobalData* globalData;
+    unsigned generation;
+    VMStubCaches* caches;
+};
+
+static VMStubCaches& vmStubCaches(JSGlobalData& globalData)
+{
+    // Looking the caches up takes a lock, so remember the answer for this thread.
+    DEFINE_STATIC_LOCAL(ThreadSpecific<LastVMStubCaches>, lastCaches, ());
+
+    LastVMStubCaches& last = *lastCaches;
+    unsigned generation = VMStubCacheMap::generation();
+    if (last.globalData != &globalData || last.generation != generation) {
+        last.caches = VMStubCacheMap::ensure(globalData);
+        last.globalData = &globalData;
+        last.generation = generation;
+    }
+    return *last.caches;
+}
+
 NEVER_INLINE static void tryCachePutByID(CallFrame* callFrame, CodeBlock* codeBlock, ReturnAddressPtr returnAddress, JSValue baseValue, const PutPropertySlot& slot, StructureStubInfo* stubInfo, bool direct)
 {
     // The interpreter checks for recursion here; I do not believe this can occur in CTI.
@@ -887,6 +1778,50 @@ NEVER_INLINE static void tryCachePutByID(CallFrame* callFrame, CodeBlock* codeBl
     stubInfo->initPutByIdReplace(callFrame->globalData(), codeBlock->ownerExecutable(), structure);
 
     JIT::patchPutByIdReplace(codeBlock, stubInfo, structure, slot.cachedOffset(), returnAddress, direct);
+
+    // patchPutByIdReplace sends further misses to the generic stub; send them through the
+    // polymorphic list instead. Transition stubs already fall back to the fail stub.
+    ctiPatchCallByReturnAddress(codeBlock, returnAddress, FunctionPtr(direct ? cti_op_put_by_id_direct_fail : cti_op_put_by_id_fail));
+}
+
+NEVER_INLINE static void tryCachePutByIDList(CallFrame* callFrame, CodeBlock* codeBlock, ReturnAddressPtr returnAddress, JSValue baseValue, const Identifier& propertyName, const PutPropertySlot& slot, bool direct)
+{
+    if (!baseValue.isCell())
+        return;
+
+    JSCell* baseCell = baseValue.asCell();
+    Structure* structure = baseCell->structure();
+
+    if (!slot.isCacheable()
+        || structure->isUncacheableDictionary()
+        || structure->typeInfo().prohibitsPropertyCaching()
+        || baseCell != slot.base()) {
+        ctiPatchCallByReturnAddress(codeBlock, returnAddress, FunctionPtr(direct ? cti_op_put_by_id_direct_generic : cti_op_put_by_id_generic));
+        return;
+    }
+
+    PolymorphicPutByIdList* list = vmStubCaches(callFrame->globalData()).putByIdLists.ensure(codeBlock->ownerExecutable(), returnAddress);
+    if (!list) {
+        COUNT_STUB_EVENT("put_by_id list cache conflicts");
+        ctiPatchCallByReturnAddress(codeBlock, returnAddress, FunctionPtr(direct ? cti_op_put_by_id_direct_generic : cti_op_put_by_id_generic));
+        return;
+    }
+
+    bool added;
+    if (slot.type() == PutPropertySlot::NewProperty) {
+        if (structure->isDictionary() || normalizePrototypeChain(callFrame, baseCell) == InvalidPrototypeChain) {
+            ctiPatchCallByReturnAddress(codeBlock, returnAddress, FunctionPtr(direct ? cti_op_put_by_id_direct_generic : cti_op_put_by_id_generic));
+            return;
+        }
+        StructureChain* prototypeChain = direct ? 0 : structure->prototypeChain(callFrame);
+        added = list->addTransition(structure->previousID(), structure, prototypeChain, propertyName, slot.cachedOffset(), direct);
+    } else
+        added = list->addReplace(structure, propertyName, slot.cachedOffset(), direct);
+
+    if (!added) {
+        COUNT_STUB_EVENT("put_by_id megamorphic sites");
+        ctiPatchCallByReturnAddress(codeBlock, returnAddress, FunctionPtr(direct ? cti_op_put_by_id_direct_generic : cti_op_put_by_id_generic));
+    }
 }
 
 NEVER_INLINE static void tryCacheGetByID(CallFrame* callFrame, CodeBlock* codeBlock, ReturnAddressPtr returnAddress, JSValue baseValue, const Identifier& propertyName, const PropertySlot& slot, StructureStubInfo* stubInfo)
@@ -981,18 +1916,186 @@ NEVER_INLINE static void tryCacheGetByID(CallFrame* callFrame, CodeBlock* codeBl
         return;
     }
 
-    PropertyOffset offset = slot.cachedOffset();
-    size_t count = normalizePrototypeChainForChainAccess(callFrame, baseValue, slot.slotBase(), propertyName, offset);
-    if (count == InvalidPrototypeChain) {
-        stubInfo->accessType = access_get_by_id_generic;
-        ctiPatchCallByReturnAddress(codeBlock, returnAddress, FunctionPtr(cti_op_get_by_id_generic));
-        return;
+    PropertyOffset offset = slot.cachedOffset();
+    size_t count = normalizePrototypeChainForChainAccess(callFrame, baseValue, slot.slotBase(), propertyName, offset);
+    if (count == InvalidPrototypeChain) {
+        stubInfo->accessType = access_get_by_id_generic;
+        ctiPatchCallByReturnAddress(codeBlock, returnAddress, FunctionPtr(cti_op_get_by_id_generic));
+        return;
+    }
+
+    StructureChain* prototypeChain = structure->prototypeChain(callFrame);
+    stubInfo->initGetByIdChain(callFrame->globalData(), codeBlock->ownerExecutable(), structure, prototypeChain, count, slot.cachedPropertyType() == PropertySlot::Value);
+    JIT::compileGetByIdChain(callFrame->scope()->globalData(), callFrame, codeBlock, stubInfo, structure, prototypeChain, count, propertyName, slot, offset, returnAddress);
+}
+
+#if ENABLE(JIT_STUB_PROFILING)
+
+// Counts every call to a stub and times one call in every sampleInterval, attributing the
+// sampled calls to the bytecode that made them. Times are inclusive of any JS the stub
+// re-enters. The table, sorted by estimated time, is dumped when the process exits.
+class JITStubProfile {
+    WTF_MAKE_NONCOPYABLE(JITStubProfile);
+public:
+    static const unsigned sampleInterval = 16;
+    static const unsigned histogramSize = 16;
+
+    JITStubProfile(const char* name)
+        : m_name(name)
+        , m_calls(0)
+        , m_samples(0)
+        , m_sampledTime(0)
+        , m_next(s_profiles)
+    {
+        if (!s_profiles)
+            atexit(dump);
+        s_profiles = this;
+        memset(m_histogram, 0, sizeof(m_histogram));
+    }
+
+    ALWAYS_INLINE bool didCall() { return !(++m_calls % sampleInterval); }
+    bool willSample(CallFrame*, ReturnAddressPtr);
+    void didSample(double time);
+
+    static void dump();
+
+private:
+    struct Site {
+        Site()
+            : samples(0)
+        {
+        }
+        CString codeBlock;
+        unsigned bytecodeOffset;
+        unsigned samples;
+    };
+    typedef HashMap<pair<CodeBlock*, unsigned>, Site> SiteMap;
+
+    static bool isHotterThan(JITStubProfile* a, JITStubProfile* b) { return a->estimatedTime() > b->estimatedTime(); }
+    static bool siteIsHotterThan(const Site* a, const Site* b) { return a->samples > b->samples; }
+    double estimatedTime() const { return m_sampledTime * sampleInterval; }
+    void dumpProfile() const;
+
+    const char* m_name;
+    unsigned long long m_calls;
+    unsigned m_samples;
+    double m_sampledTime;
+    unsigned m_histogram[histogramSize];
+    SiteMap m_sites;
+    JITStubProfile* m_next;
+
+    static JITStubProfile* s_profiles;
+};
+
+JITStubProfile* JITStubProfile::s_profiles = 0;
+
+static bool jitCodeContains(CodeBlock* codeBlock, ReturnAddressPtr returnAddress)
+{
+    if (!codeBlock || codeBlock->getJITType() != JITCode::BaselineJIT)
+        return false;
+    char* start = static_cast<char*>(codeBlock->getJITCode().start());
+    char* address = static_cast<char*>(returnAddress.value());
+    return address > start && address <= start + codeBlock->getJITCode().size();
+}
+
+// Attributes the sample to the call site that made it, by mapping the return address into
+// callFrame's CodeBlock. This has to happen on entry, before the stub can re-enter JS or
+// replace the frame.
+bool JITStubProfile::willSample(CallFrame* callFrame, ReturnAddressPtr returnAddress)
+{
+    CodeBlock* codeBlock = callFrame->codeBlock();
+    if (!jitCodeContains(codeBlock, returnAddress))
+        return false;
+    unsigned bytecodeOffset = codeBlock->bytecodeOffset(callFrame, returnAddress);
+    SiteMap::AddResult result = m_sites.add(make_pair(codeBlock, bytecodeOffset), Site());
+    if (result.isNewEntry) {
+        result.iterator->value.codeBlock = toCString(*codeBlock);
+        result.iterator->value.bytecodeOffset = bytecodeOffset;
+    }
+    ++result.iterator->value.samples;
+    return true;
+}
+
+void JITStubProfile::didSample(double time)
+{
+    ++m_samples;
+    m_sampledTime += time;
+
+    // Bucket i holds samples that took less than 2^i microseconds.
+    unsigned bucket = 0;
+    for (double micros = time * 1000000; micros >= 1 && bucket < histogramSize - 1; micros /= 2)
+        ++bucket;
+    ++m_histogram[bucket];
+}
+
+void JITStubProfile::dumpProfile() const
+{
+    dataLogF("%-48s %12llu %12.3f  ", m_name, m_calls, estimatedTime() * 1000);
+    for (unsigned i = 0; i < histogramSize; ++i)
+        dataLogF(" %u", m_histogram[i]);
+    dataLogF("\n");
+
+    Vector<const Site*> sites;
+    for (SiteMap::const_iterator iter = m_sites.begin(); iter != m_sites.end(); ++iter)
+        sites.append(&iter->value);
+    std::sort(sites.begin(), sites.end(), siteIsHotterThan);
+    for (size_t i = 0; i < sites.size() && i < 5; ++i)
+        dataLogF("    %6u samples at bc#%u in %s\n", sites[i]->samples, sites[i]->bytecodeOffset, sites[i]->codeBlock.data());
+}
+
+void JITStubProfile::dump()
+{
+    Vector<JITStubProfile*> profiles;
+    for (JITStubProfile* profile = s_profiles; profile; profile = profile->m_next) {
+        if (profile->m_calls)
+            profiles.append(profile);
+    }
+    std::sort(profiles.begin(), profiles.end(), isHotterThan);
+
+    dataLogF("\nJIT stub profile (1 in %u calls timed, histogram buckets are log2 microseconds):\n", sampleInterval);
+    dataLogF("%-48s %12s %12s   %s\n", "Stub", "Calls", "Est. ms", "Histogram");
+    for (size_t i = 0; i < profiles.size(); ++i)
+        profiles[i]->dumpProfile();
+}
+
+enum StubFrameKind { StubRunsOnCallerFrame, StubRunsOnCalleeFrame };
+
+class JITStubProfileScope {
+public:
+    ALWAYS_INLINE JITStubProfileScope(JITStubProfile& profile, StubFrameKind kind, CallFrame* callFrame, ReturnAddressPtr returnAddress)
+        : m_profile(profile)
+        , m_startTime(0)
+    {
+        if (UNLIKELY(profile.didCall())) {
+            // A callee frame's CodeBlock slot is not initialized until the stub nulls or sets it,
+            // so those stubs are attributed through the caller's CodeBlock only. Stubs called from
+            // the caller's code have its return address; those entered through a call thunk have
+            // the caller's return address in the callee frame's ReturnPC slot instead.
+            if (kind == StubRunsOnCallerFrame)
+                profile.willSample(callFrame, returnAddress);
+            else if (CallFrame* callerFrame = callFrame->callerFrame()->removeHostCallFrameFlag()) {
+                if (!profile.willSample(callerFrame, returnAddress))
+                    profile.willSample(callerFrame, callFrame->returnPC());
+            }
+            m_startTime = monotonicallyIncreasingTime();
+        }
+    }
+
+    ALWAYS_INLINE ~JITStubProfileScope()
+    {
+        if (m_startTime)
+            m_profile.didSample(monotonicallyIncreasingTime() - m_startTime);
     }
 
-    StructureChain* prototypeChain = structure->prototypeChain(callFrame);
-    stubInfo->initGetByIdChain(callFrame->globalData(), codeBlock->ownerExecutable(), structure, prototypeChain, count, slot.cachedPropertyType() == PropertySlot::Value);
-    JIT::compileGetByIdChain(callFrame->scope()->globalData(), callFrame, codeBlock, stubInfo, structure, prototypeChain, count, propertyName, slot, offset, returnAddress);
-}
+private:
+    JITStubProfile& m_profile;
+    double m_startTime;
+};
+
+#define STUB_PROFILE_SCOPE(stackFrame, kind) static JITStubProfile stubProfile(__FUNCTION__); JITStubProfileScope stubProfileScope(stubProfile, kind, stackFrame.callFrame, STUB_RETURN_ADDRESS)
+#else
+#define STUB_PROFILE_SCOPE(stackFrame, kind)
+#endif
 
 #if !defined(NDEBUG)
 
@@ -1025,13 +2128,15 @@ struct StackHack {
     ReturnAddressPtr savedReturnAddress;
 };
 
-#define STUB_INIT_STACK_FRAME(stackFrame) JITStackFrame& stackFrame = *reinterpret_cast_ptr<JITStackFrame*>(STUB_ARGS); StackHack stackHack(stackFrame)
+#define STUB_INIT_STACK_FRAME(stackFrame) JITStackFrame& stackFrame = *reinterpret_cast_ptr<JITStackFrame*>(STUB_ARGS); StackHack stackHack(stackFrame); STUB_PROFILE_SCOPE(stackFrame, StubRunsOnCallerFrame)
+#define STUB_INIT_CALLEE_STACK_FRAME(stackFrame) JITStackFrame& stackFrame = *reinterpret_cast_ptr<JITStackFrame*>(STUB_ARGS); StackHack stackHack(stackFrame); STUB_PROFILE_SCOPE(stackFrame, StubRunsOnCalleeFrame)
 #define STUB_SET_RETURN_ADDRESS(returnAddress) stackHack.savedReturnAddress = ReturnAddressPtr(returnAddress)
 #define STUB_RETURN_ADDRESS stackHack.savedReturnAddress
 
 #else
 
-#define STUB_INIT_STACK_FRAME(stackFrame) JITStackFrame& stackFrame = *reinterpret_cast_ptr<JITStackFrame*>(STUB_ARGS)
+#define STUB_INIT_STACK_FRAME(stackFrame) JITStackFrame& stackFrame = *reinterpret_cast_ptr<JITStackFrame*>(STUB_ARGS); STUB_PROFILE_SCOPE(stackFrame, StubRunsOnCallerFrame)
+#define STUB_INIT_CALLEE_STACK_FRAME(stackFrame) JITStackFrame& stackFrame = *reinterpret_cast_ptr<JITStackFrame*>(STUB_ARGS); STUB_PROFILE_SCOPE(stackFrame, StubRunsOnCalleeFrame)
 #define STUB_SET_RETURN_ADDRESS(returnAddress) *stackFrame.returnAddressSlot() = ReturnAddressPtr(returnAddress)
 #define STUB_RETURN_ADDRESS *stackFrame.returnAddressSlot()
 
@@ -1422,6 +2527,122 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_convert_this)
     return JSValue::encode(result);
 }
 
+#if ENABLE(ARITHMETIC_PROFILING)
+// Records what each arithmetic site looked like when its int32 fast path bailed out to a
+// stub, so a site that keeps missing on doubles or overflow can be told apart from one that
+// sees non-numbers. The profiles are dumped when the process exits.
+class ArithmeticProfiles {
+public:
+    enum Observation {
+        Int32Result,
+        Int32Overflow,
+        Int52Overflow,
+        NonIntegerResult,
+        DoubleOperand,
+        NaNOrNegativeZeroResult,
+        NonNumberOperand,
+        NumberOfObservations
+    };
+
+    static void record(CallFrame*, const char* opcode, JSValue left, JSValue right, JSValue result);
+
+private:
+    struct Site {
+        Site()
+            : opcode(0)
+            , bytecodeOffset(0)
+            , total(0)
+        {
+            memset(counts, 0, sizeof(counts));
+        }
+
+        const char* opcode;
+        CString codeBlock;
+        unsigned bytecodeOffset;
+        unsigned total;
+        unsigned counts[NumberOfObservations];
+    };
+    typedef HashMap<pair<CodeBlock*, unsigned>, Site> SiteMap;
+
+    static Observation classify(JSValue left, JSValue right, JSValue result);
+    static bool isHotterThan(const Site* a, const Site* b) { return a->total > b->total; }
+    static void dump();
+
+    static SiteMap* s_sites;
+};
+
+ArithmeticProfiles::SiteMap* ArithmeticProfiles::s_sites = 0;
+
+ArithmeticProfiles::Observation ArithmeticProfiles::classify(JSValue left, JSValue right, JSValue result)
+{
+    if (!left.isNumber() || (right && !right.isNumber()))
+        return NonNumberOperand;
+    if (result.isDouble()) {
+        double value = result.asDouble();
+        if (std::isnan(value) || (!value && std::signbit(value)))
+            return NaNOrNegativeZeroResult;
+    }
+    if (left.isDouble() || (right && right.isDouble()))
+        return DoubleOperand;
+    // Both operands were int32s. For div and mod the result need not be an integer at all.
+    double value = result.asNumber();
+    if (value != trunc(value))
+        return NonIntegerResult;
+    if (value == static_cast<int32_t>(value))
+        return Int32Result;
+    if (value >= -2251799813685248.0 && value < 2251799813685248.0) // Within [-2^51, 2^51).
+        return Int32Overflow;
+    return Int52Overflow;
+}
+
+void ArithmeticProfiles::record(CallFrame* callFrame, const char* opcode, JSValue left, JSValue right, JSValue result)
+{
+    CodeBlock* codeBlock = callFrame->codeBlock();
+    if (!codeBlock || codeBlock->getJITType() != JITCode::BaselineJIT)
+        return;
+
+    if (!s_sites) {
+        s_sites = new SiteMap;
+        atexit(dump);
+    }
+
+    // Stub calls leave the offset of the instruction that made them plus one in the frame.
+    unsigned bytecodeOffset = callFrame->bytecodeOffsetForNonDFGCode() - 1;
+    SiteMap::AddResult addResult = s_sites->add(make_pair(codeBlock, bytecodeOffset), Site());
+    Site& site = addResult.iterator->value;
+    if (addResult.isNewEntry) {
+        site.opcode = opcode;
+        site.codeBlock = toCString(*codeBlock);
+        site.bytecodeOffset = bytecodeOffset;
+    }
+    ++site.total;
+    ++site.counts[classify(left, right, result)];
+}
+
+void ArithmeticProfiles::dump()
+{
+    Vector<const Site*> sites;
+    for (SiteMap::const_iterator iter = s_sites->begin(); iter != s_sites->end(); ++iter)
+        sites.append(&iter->value);
+    std::sort(sites.begin(), sites.end(), isHotterThan);
+
+    dataLogF("\nArithmetic slow path profile:\n");
+    dataLogF("%-8s %10s %10s %10s %10s %10s %10s %10s %10s  %s\n", "Opcode", "Total", "Int32", "Int32Ovf", "Int52Ovf", "NonInt", "Double", "NaN/-0", "NonNumber", "Site");
+    for (size_t i = 0; i < sites.size(); ++i) {
+        const Site* site = sites[i];
+        dataLogF("%-8s %10u %10u %10u %10u %10u %10u %10u %10u  bc#%u in %s\n", site->opcode, site->total,
+            site->counts[Int32Result], site->counts[Int32Overflow], site->counts[Int52Overflow],
+            site->counts[NonIntegerResult], site->counts[DoubleOperand],
+            site->counts[NaNOrNegativeZeroResult], site->counts[NonNumberOperand],
+            site->bytecodeOffset, site->codeBlock.data());
+    }
+}
+
+#define RECORD_ARITHMETIC(opcode, left, right, result) ArithmeticProfiles::record(stackFrame.callFrame, opcode, left, right, result)
+#else
+#define RECORD_ARITHMETIC(opcode, left, right, result) do { } while (0)
+#endif
+
 DEFINE_STUB_FUNCTION(EncodedJSValue, op_add)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
@@ -1430,6 +2651,8 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_add)
     JSValue v2 = stackFrame.args[1].jsValue();
     CallFrame* callFrame = stackFrame.callFrame;
 
+    // String concatenation builds ropes, here and in jsAddSlowCase for primitive + string, so
+    // repeated += stays linear; op_strcat builds a single rope for a run of operands.
     if (v1.isString() && !v2.isObject()) {
         JSValue result = jsString(callFrame, asString(v1), v2.toString(callFrame));
         CHECK_FOR_EXCEPTION_AT_END();
@@ -1457,22 +2680,176 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_pre_inc)
     return JSValue::encode(result);
 }
 
+static const unsigned frequentTicksUntilNextCheck = 1024;
+
+// A sampling profiler that costs nothing on calls. A timer thread asks for a sample every
+// interval, and the JS thread takes it the next time it passes through cti_timeout_check,
+// walking its call frames into a folded stack ("outer;...;inner count", as read by
+// flamegraph.pl). Samples are therefore taken at loop back edges, which is where JIT code
+// polls; straight-line code that never loops is attributed to its nearest looping caller.
+// A profiler samples a single JSGlobalData, so samples are only ever taken under its JSLock.
+class StubSamplingProfiler {
+    WTF_MAKE_NONCOPYABLE(StubSamplingProfiler); WTF_MAKE_FAST_ALLOCATED;
+public:
+    StubSamplingProfiler(double interval)
+        : m_interval(interval)
+        , m_stopped(false)
+        , m_sampleRequested(false)
+        , m_sampleCount(0)
+    {
+        m_thread = createThread(threadMain, this, "JSC sampling profiler");
+    }
+
+    bool sampleRequested() const { return m_sampleRequested; }
+    void takeSample(CallFrame*);
+    bool stop(const char* path);
+
+private:
+    static void threadMain(void*);
+    static void appendFrame(StringBuilder&, CallFrame*, bool isLeaf);
+
+    double m_interval;
+    Mutex m_lock;
+    ThreadCondition m_condition;
+    bool m_stopped;
+    volatile bool m_sampleRequested;
+    ThreadIdentifier m_thread;
+    HashMap<String, unsigned> m_stacks;
+    unsigned m_sampleCount;
+};
+
+void StubSamplingProfiler::threadMain(void* context)
+{
+    StubSamplingProfiler* profiler = static_cast<StubSamplingProfiler*>(context);
+    MutexLocker locker(profiler->m_lock);
+    while (!profiler->m_stopped) {
+        profiler->m_condition.timedWait(profiler->m_lock, currentTime() + profiler->m_interval);
+        profiler->m_sampleRequested = true;
+    }
+}
+
+void StubSamplingProfiler::appendFrame(StringBuilder& builder, CallFrame* frame, bool isLeaf)
+{
+    CodeBlock* codeBlock = frame->codeBlock();
+    if (!codeBlock) {
+        builder.append("[native]");
+        return;
+    }
+    // inferredName() is already UTF-8; decode it so that toString().utf8() does not encode it twice.
+    builder.append(String::fromUTF8(codeBlock->inferredName().data()));
+    if (codeBlock->getJITType() == JITCode::BaselineJIT) {
+        // The leaf is sampled from inside cti_timeout_check, and stub calls leave the offset of
+        // the calling instruction plus one in the frame.
+        unsigned bytecodeOffset = frame->bytecodeOffsetForNonDFGCode();
+        builder.append("@bc#");
+        builder.appendNumber(isLeaf ? bytecodeOffset - 1 : bytecodeOffset);
+    }
+}
+
+void StubSamplingProfiler::takeSample(CallFrame* callFrame)
+{
+    m_sampleRequested = false;
+
+    Vector<CallFrame*, 32> frames;
+    for (CallFrame* frame = callFrame; frame; frame = frame->callerFrame()->removeHostCallFrameFlag())
+        frames.append(frame);
+
+    StringBuilder builder;
+    for (size_t i = frames.size(); i--;) {
+        appendFrame(builder, frames[i], !i);
+        if (i)
+            builder.append(';');
+    }
+
+    HashMap<String, unsigned>::AddResult result = m_stacks.add(builder.toString(), 0);
+    ++result.iterator->value;
+    ++m_sampleCount;
+}
+
+bool StubSamplingProfiler::stop(const char* path)
+{
+    {
+        MutexLocker locker(m_lock);
+        m_stopped = true;
+        m_condition.signal();
+    }
+    waitForThreadCompletion(m_thread);
+
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return false;
+    for (HashMap<String, unsigned>::const_iterator iter = m_stacks.begin(); iter != m_stacks.end(); ++iter)
+        fprintf(file, "%s %u\n", iter->key.utf8().data(), iter->value);
+    fclose(file);
+    dataLogF("Sampling profiler wrote %u samples (%u distinct stacks) to %s\n", m_sampleCount, m_stacks.size(), path);
+    return true;
+}
+
+void setFrequentTimeoutChecks(JSGlobalData& globalData, bool enabled)
+{
+    TimeoutCheckPacing& pacing = vmStubCaches(globalData).timeoutCheckPacing;
+    if (enabled)
+        ++pacing.frequentCheckRequests;
+    else {
+        ASSERT(pacing.frequentCheckRequests);
+        --pacing.frequentCheckRequests;
+    }
+}
+
+void startStubSamplingProfiler(JSGlobalData& globalData, double intervalInSeconds)
+{
+    VMStubCaches& caches = vmStubCaches(globalData);
+    ASSERT(!caches.samplingProfiler);
+    caches.samplingProfiler = new StubSamplingProfiler(intervalInSeconds);
+}
+
+bool stopStubSamplingProfiler(JSGlobalData& globalData, const char* foldedStacksPath)
+{
+    VMStubCaches& caches = vmStubCaches(globalData);
+    StubSamplingProfiler* profiler = caches.samplingProfiler;
+    ASSERT(profiler);
+    caches.samplingProfiler = 0;
+    bool result = profiler->stop(foldedStacksPath);
+    delete profiler;
+    return result;
+}
+
 DEFINE_STUB_FUNCTION(int, timeout_check)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
 
     JSGlobalData* globalData = stackFrame.globalData;
     TimeoutChecker& timeoutChecker = globalData->timeoutChecker;
+    VMStubCaches& caches = vmStubCaches(*globalData);
+    TimeoutCheckPacing& pacing = caches.timeoutCheckPacing;
+
+    StubSamplingProfiler* profiler = caches.samplingProfiler;
+    if (UNLIKELY(profiler && profiler->sampleRequested()))
+        profiler->takeSample(stackFrame.callFrame);
+
+    bool checkerIsDue = pacing.checkerTicksLeft <= pacing.lastInterval;
+    if (checkerIsDue)
+        pacing.checkerTicksLeft = 0;
+    else
+        pacing.checkerTicksLeft -= pacing.lastInterval;
 
     if (globalData->terminator.shouldTerminate()) {
         globalData->exception = createTerminatedExecutionException(globalData);
         VM_THROW_EXCEPTION_AT_END();
-    } else if (timeoutChecker.didTimeOut(stackFrame.callFrame)) {
+    } else if (checkerIsDue && timeoutChecker.didTimeOut(stackFrame.callFrame)) {
         globalData->exception = createInterruptedExecutionException(globalData);
         VM_THROW_EXCEPTION_AT_END();
     }
 
-    return timeoutChecker.ticksUntilNextCheck();
+    if (checkerIsDue)
+        pacing.checkerTicksLeft = timeoutChecker.ticksUntilNextCheck();
+    unsigned interval = pacing.checkerTicksLeft;
+    // The checker spaces its checks about a second apart, far too coarse to sample with or to
+    // notice a terminateSoon() from a short watchdog.
+    if (profiler || pacing.frequentCheckRequests)
+        interval = std::min(interval, frequentTicksUntilNextCheck);
+    pacing.lastInterval = interval;
+    return interval;
 }
 
 DEFINE_STUB_FUNCTION(void*, stack_check)
@@ -1521,10 +2898,16 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_get_by_id_generic)
     Identifier& ident = stackFrame.args[1].identifier();
 
     JSValue baseValue = stackFrame.args[0].jsValue();
+    MegamorphicGetByIdCache* cache = &vmStubCaches(callFrame->globalData()).getById;
+    JSValue result;
+    if (cache->tryGet(callFrame, baseValue, ident, result))
+        return JSValue::encode(result);
+
     PropertySlot slot(baseValue);
-    JSValue result = baseValue.get(callFrame, ident, slot);
+    result = baseValue.get(callFrame, ident, slot);
+    CHECK_FOR_EXCEPTION();
 
-    CHECK_FOR_EXCEPTION_AT_END();
+    cache->add(callFrame, baseValue, ident, slot);
     return JSValue::encode(result);
 }
 
@@ -1583,26 +2966,41 @@ DEFINE_STUB_FUNCTION(void, op_put_by_id_fail)
 
     CallFrame* callFrame = stackFrame.callFrame;
     Identifier& ident = stackFrame.args[1].identifier();
-    
-    PutPropertySlot slot(callFrame->codeBlock()->isStrictMode());
-    stackFrame.args[0].jsValue().put(callFrame, ident, stackFrame.args[2].jsValue(), slot);
+    JSValue baseValue = stackFrame.args[0].jsValue();
+    JSValue value = stackFrame.args[2].jsValue();
 
-    CHECK_FOR_EXCEPTION_AT_END();
+    CodeBlock* codeBlock = callFrame->codeBlock();
+    PolymorphicPutByIdList* list = vmStubCaches(callFrame->globalData()).putByIdLists.get(STUB_RETURN_ADDRESS);
+    if (list && list->tryPut(callFrame->globalData(), baseValue, ident, value, false))
+        return;
+
+    PutPropertySlot slot(codeBlock->isStrictMode());
+    baseValue.put(callFrame, ident, value, slot);
+    CHECK_FOR_EXCEPTION_VOID();
+
+    tryCachePutByIDList(callFrame, codeBlock, STUB_RETURN_ADDRESS, baseValue, ident, slot, false);
 }
 
 DEFINE_STUB_FUNCTION(void, op_put_by_id_direct_fail)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
-    
+
     CallFrame* callFrame = stackFrame.callFrame;
     Identifier& ident = stackFrame.args[1].identifier();
-    
-    PutPropertySlot slot(callFrame->codeBlock()->isStrictMode());
     JSValue baseValue = stackFrame.args[0].jsValue();
+    JSValue value = stackFrame.args[2].jsValue();
     ASSERT(baseValue.isObject());
-    asObject(baseValue)->putDirect(callFrame->globalData(), ident, stackFrame.args[2].jsValue(), slot);
-    
-    CHECK_FOR_EXCEPTION_AT_END();
+
+    CodeBlock* codeBlock = callFrame->codeBlock();
+    PolymorphicPutByIdList* list = vmStubCaches(callFrame->globalData()).putByIdLists.get(STUB_RETURN_ADDRESS);
+    if (list && list->tryPut(callFrame->globalData(), baseValue, ident, value, true))
+        return;
+
+    PutPropertySlot slot(codeBlock->isStrictMode());
+    asObject(baseValue)->putDirect(callFrame->globalData(), ident, value, slot);
+    CHECK_FOR_EXCEPTION_VOID();
+
+    tryCachePutByIDList(callFrame, codeBlock, STUB_RETURN_ADDRESS, baseValue, ident, slot, true);
 }
 
 DEFINE_STUB_FUNCTION(JSObject*, op_put_by_id_transition_realloc)
@@ -1620,6 +3018,10 @@ DEFINE_STUB_FUNCTION(JSObject*, op_put_by_id_transition_realloc)
     ASSERT(baseValue.isObject());
     JSObject* base = asObject(baseValue);
     JSGlobalData& globalData = *stackFrame.globalData;
+    if (!oldSize)
+        COUNT_STUB_EVENT("put_by_id transitions allocating out-of-line storage");
+    else
+        COUNT_STUB_EVENT("put_by_id transitions reallocating out-of-line storage");
     Butterfly* butterfly = base->growOutOfLineStorage(globalData, oldSize, newSize);
     base->setButterfly(globalData, butterfly, newStructure);
 
@@ -1742,6 +3144,10 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_get_by_id_getter_stub)
     JSObject* getter = asObject(getterSetter->getter());
     CallData callData;
     CallType callType = getter->methodTable()->getCallData(getter, callData);
+    if (callType == CallTypeJS)
+        COUNT_STUB_EVENT("get_by_id getter stub calls to JS functions");
+    else
+        COUNT_STUB_EVENT("get_by_id getter stub calls to host functions");
     JSValue result = call(callFrame, getter, callType, callData, stackFrame.args[1].jsObject(), ArgList());
     if (callFrame->hadException())
         returnToThrowTrampoline(&callFrame->globalData(), stackFrame.args[2].returnAddress(), STUB_RETURN_ADDRESS);
@@ -1756,6 +3162,7 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_get_by_id_custom_stub)
     JSObject* slotBase = stackFrame.args[0].jsObject();
     PropertySlot::GetValueFunc getter = reinterpret_cast<PropertySlot::GetValueFunc>(stackFrame.args[1].asPointer);
     const Identifier& ident = stackFrame.args[2].identifier();
+    COUNT_STUB_EVENT("get_by_id custom accessor stub calls");
     JSValue result = getter(callFrame, slotBase, ident);
     if (callFrame->hadException())
         returnToThrowTrampoline(&callFrame->globalData(), stackFrame.args[3].returnAddress(), STUB_RETURN_ADDRESS);
@@ -1848,11 +3255,20 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_get_by_id_proto_list_full)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
 
+    CallFrame* callFrame = stackFrame.callFrame;
+    const Identifier& ident = stackFrame.args[1].identifier();
+
     JSValue baseValue = stackFrame.args[0].jsValue();
+    MegamorphicGetByIdCache* cache = &vmStubCaches(callFrame->globalData()).getById;
+    JSValue result;
+    if (cache->tryGet(callFrame, baseValue, ident, result))
+        return JSValue::encode(result);
+
     PropertySlot slot(baseValue);
-    JSValue result = baseValue.get(stackFrame.callFrame, stackFrame.args[1].identifier(), slot);
+    result = baseValue.get(callFrame, ident, slot);
+    CHECK_FOR_EXCEPTION();
 
-    CHECK_FOR_EXCEPTION_AT_END();
+    cache->add(callFrame, baseValue, ident, slot);
     return JSValue::encode(result);
 }
 
@@ -1904,6 +3320,7 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_check_has_instance)
         JSObject* baseObject = asObject(baseVal);
         ASSERT(!baseObject->structure()->typeInfo().implementsDefaultHasInstance());
         if (baseObject->structure()->typeInfo().implementsHasInstance()) {
+            COUNT_STUB_EVENT("instanceof slow path: custom hasInstance");
             bool result = baseObject->methodTable()->customHasInstance(baseObject, callFrame, value);
             CHECK_FOR_EXCEPTION_AT_END();
             return JSValue::encode(jsBoolean(result));
@@ -2062,12 +3479,50 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_instanceof)
     JSValue proto = stackFrame.args[1].jsValue();
     
     ASSERT(!value.isObject() || !proto.isObject());
+    COUNT_STUB_EVENT("instanceof slow path: non-object operand");
 
     bool result = JSObject::defaultHasInstance(callFrame, value, proto);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(jsBoolean(result));
 }
 
+// Deleting a property normally turns the object's structure into an uncacheable dictionary.
+// When the property is the one most recently added (obj.tmp = x; ...; delete obj.tmp), the
+// object can instead go back to the structure it had before the add, which is shared and
+// cacheable.
+static bool tryDeleteByRevertingTransition(JSGlobalData& globalData, JSObject* object, const Identifier& propertyName)
+{
+    if (object->methodTable()->deleteProperty != JSObject::deleteProperty)
+        return false;
+
+    Structure* structure = object->structure();
+    Structure* previous = structure->previousID();
+    if (!previous || structure->isDictionary() || previous->isDictionary())
+        return false;
+
+    unsigned attributes;
+    JSCell* specificValue;
+    PropertyOffset offset = structure->get(globalData, propertyName, attributes, specificValue);
+    if (!isValidOffset(offset) || (attributes & DontDelete))
+        return false;
+
+    // The previous structure must be the one the property was added to, and nothing else may
+    // have changed on the way. The out-of-line capacity has to match as well, since it decides
+    // where the butterfly begins.
+    if (isValidOffset(previous->get(globalData, propertyName))
+        || previous->inlineSize() + previous->outOfLineSize() + 1 != structure->inlineSize() + structure->outOfLineSize()
+        || previous->outOfLineCapacity() != structure->outOfLineCapacity()
+        || previous->storedPrototype() != structure->storedPrototype()
+        || previous->indexingTypeIncludingHistory() != structure->indexingTypeIncludingHistory()
+        || previous->classInfo() != structure->classInfo())
+        return false;
+
+    structure->notifyTransitionFromThisStructure();
+    object->locationForOffset(offset)->clear();
+    object->setStructure(globalData, previous);
+    return true;
+}
+
 DEFINE_STUB_FUNCTION(EncodedJSValue, op_del_by_id)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
@@ -2076,7 +3531,15 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_del_by_id)
     
     JSObject* baseObj = stackFrame.args[0].jsValue().toObject(callFrame);
 
+    if (tryDeleteByRevertingTransition(*stackFrame.globalData, baseObj, stackFrame.args[1].identifier())) {
+        COUNT_STUB_EVENT("del_by_id reverted to previous structure");
+        return JSValue::encode(jsBoolean(true));
+    }
+
+    bool wasDictionary = baseObj->structure()->isDictionary();
     bool couldDelete = baseObj->methodTable()->deleteProperty(baseObj, callFrame, stackFrame.args[1].identifier());
+    if (!wasDictionary && baseObj->structure()->isDictionary())
+        COUNT_STUB_EVENT("objects forced into dictionary mode by del_by_id");
     JSValue result = jsBoolean(couldDelete);
     if (!couldDelete && callFrame->codeBlock()->isStrictMode())
         stackFrame.globalData->exception = createTypeError(stackFrame.callFrame, "Unable to delete property.");
@@ -2092,11 +3555,15 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_mul)
     JSValue src1 = stackFrame.args[0].jsValue();
     JSValue src2 = stackFrame.args[1].jsValue();
 
-    if (src1.isNumber() && src2.isNumber())
-        return JSValue::encode(jsNumber(src1.asNumber() * src2.asNumber()));
+    if (src1.isNumber() && src2.isNumber()) {
+        JSValue result = jsNumber(src1.asNumber() * src2.asNumber());
+        RECORD_ARITHMETIC("mul", src1, src2, result);
+        return JSValue::encode(result);
+    }
 
     CallFrame* callFrame = stackFrame.callFrame;
     JSValue result = jsNumber(src1.toNumber(callFrame) * src2.toNumber(callFrame));
+    RECORD_ARITHMETIC("mul", src1, src2, result);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(result);
 }
@@ -2109,6 +3576,69 @@ DEFINE_STUB_FUNCTION(JSObject*, op_new_func)
     return JSFunction::create(stackFrame.callFrame, stackFrame.args[0].function(), stackFrame.callFrame->scope());
 }
 
+#if JIT_EXECUTABLE_MEMORY_BUDGET
+// Keeps committed JIT code under JIT_EXECUTABLE_MEMORY_BUDGET. Once the budget is exceeded,
+// releaseExecutableMemory() discards the code of every function that is not on the stack; the
+// functions come back through cti_op_*_jitCompile the next time they are called. If the code
+// that survives is itself over budget, another release waits until a quarter of the budget
+// more has been committed, so that compiling does not turn into a loop of GCs.
+class ExecutableMemoryBudget {
+public:
+    static void willCompile(JSGlobalData&);
+
+private:
+    static void dumpStatistics();
+
+    static bool s_registeredDump;
+    static unsigned s_releases;
+    static unsigned s_compilesSinceFirstRelease;
+    static size_t s_bytesReleased;
+    static size_t s_bytesAfterLastRelease;
+};
+
+bool ExecutableMemoryBudget::s_registeredDump = false;
+unsigned ExecutableMemoryBudget::s_releases = 0;
+unsigned ExecutableMemoryBudget::s_compilesSinceFirstRelease = 0;
+size_t ExecutableMemoryBudget::s_bytesReleased = 0;
+size_t ExecutableMemoryBudget::s_bytesAfterLastRelease = 0;
+
+void ExecutableMemoryBudget::willCompile(JSGlobalData& globalData)
+{
+    if (!s_registeredDump) {
+        s_registeredDump = true;
+        atexit(dumpStatistics);
+    }
+
+    if (s_releases)
+        ++s_compilesSinceFirstRelease;
+
+    size_t committed = ExecutableAllocator::committedByteCount();
+    if (committed <= JIT_EXECUTABLE_MEMORY_BUDGET)
+        return;
+    if (s_releases && committed < s_bytesAfterLastRelease + JIT_EXECUTABLE_MEMORY_BUDGET / 4)
+        return;
+
+    globalData.releaseExecutableMemory();
+
+    size_t remaining = ExecutableAllocator::committedByteCount();
+    if (committed > remaining)
+        s_bytesReleased += committed - remaining;
+    s_bytesAfterLastRelease = remaining;
+    ++s_releases;
+}
+
+void ExecutableMemoryBudget::dumpStatistics()
+{
+    dataLogF("\nExecutable memory budget: %lu bytes\n", static_cast<unsigned long>(JIT_EXECUTABLE_MEMORY_BUDGET));
+    dataLogF("    bytes resident:               %lu\n", static_cast<unsigned long>(ExecutableAllocator::committedByteCount()));
+    dataLogF("    bytes released:               %lu\n", static_cast<unsigned long>(s_bytesReleased));
+    dataLogF("    releases:                     %u\n", s_releases);
+    // Discarded code is not tracked per executable, so this counts first compiles of functions
+    // that had never run as well as recompiles of functions whose code was released.
+    dataLogF("    compiles since first release: %u\n", s_compilesSinceFirstRelease);
+}
+#endif
+
 inline void* jitCompileFor(CallFrame* callFrame, CodeSpecializationKind kind)
 {
     // This function is called by cti_op_call_jitCompile() and
@@ -2128,6 +3658,10 @@ inline void* jitCompileFor(CallFrame* callFrame, CodeSpecializationKind kind)
     // Hence, we should nullify it here before proceeding with the compilation.
     callFrame->setCodeBlock(0);
 
+#if JIT_EXECUTABLE_MEMORY_BUDGET
+    ExecutableMemoryBudget::willCompile(callFrame->globalData());
+#endif
+
     JSFunction* function = jsCast<JSFunction*>(callFrame->callee());
     ASSERT(!function->isHostFunction());
     FunctionExecutable* executable = function->jsExecutable();
@@ -2141,7 +3675,7 @@ inline void* jitCompileFor(CallFrame* callFrame, CodeSpecializationKind kind)
 
 DEFINE_STUB_FUNCTION(void*, op_call_jitCompile)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
 #if !ASSERT_DISABLED
     CallData callData;
@@ -2158,7 +3692,7 @@ DEFINE_STUB_FUNCTION(void*, op_call_jitCompile)
 
 DEFINE_STUB_FUNCTION(void*, op_construct_jitCompile)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
 #if !ASSERT_DISABLED
     ConstructData constructData;
@@ -2175,7 +3709,7 @@ DEFINE_STUB_FUNCTION(void*, op_construct_jitCompile)
 
 DEFINE_STUB_FUNCTION(void*, op_call_arityCheck)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
 
@@ -2188,7 +3722,7 @@ DEFINE_STUB_FUNCTION(void*, op_call_arityCheck)
 
 DEFINE_STUB_FUNCTION(void*, op_construct_arityCheck)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
 
@@ -2243,15 +3777,17 @@ inline void* lazyLinkFor(CallFrame* callFrame, CodeSpecializationKind kind)
 
     if (!callLinkInfo->seenOnce())
         callLinkInfo->setSeen();
-    else
+    else {
+        COUNT_STUB_EVENT("call sites linked monomorphic");
         JIT::linkFor(callee, callFrame->callerFrame()->codeBlock(), codeBlock, codePtr, callLinkInfo, &callFrame->globalData(), kind);
+    }
 
     return codePtr.executableAddress();
 }
 
 DEFINE_STUB_FUNCTION(void*, vm_lazyLinkCall)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
     void* result = lazyLinkFor(callFrame, CodeForCall);
@@ -2263,7 +3799,7 @@ DEFINE_STUB_FUNCTION(void*, vm_lazyLinkCall)
 
 DEFINE_STUB_FUNCTION(void*, vm_lazyLinkClosureCall)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
     
@@ -2316,17 +3852,20 @@ DEFINE_STUB_FUNCTION(void*, vm_lazyLinkClosureCall)
     
     if (shouldLink) {
         ASSERT(codePtr);
+        COUNT_STUB_EVENT("call sites linked polymorphic (closure call)");
         JIT::compileClosureCall(globalData, callLinkInfo, callerCodeBlock, calleeCodeBlock, structure, executable, codePtr);
         callLinkInfo->hasSeenClosure = true;
-    } else
+    } else {
+        COUNT_STUB_EVENT("call sites linked megamorphic (virtual call)");
         JIT::linkSlowCall(callerCodeBlock, callLinkInfo);
+    }
 
     return codePtr.executableAddress();
 }
 
 DEFINE_STUB_FUNCTION(void*, vm_lazyLinkConstruct)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
     void* result = lazyLinkFor(callFrame, CodeForConstruct);
@@ -2340,6 +3879,7 @@ DEFINE_STUB_FUNCTION(JSObject*, op_push_activation)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
 
+    COUNT_STUB_EVENT("activations created");
     JSActivation* activation = JSActivation::create(stackFrame.callFrame->globalData(), stackFrame.callFrame, stackFrame.callFrame->codeBlock());
     stackFrame.callFrame->setScope(activation);
     return activation;
@@ -2347,7 +3887,7 @@ DEFINE_STUB_FUNCTION(JSObject*, op_push_activation)
 
 DEFINE_STUB_FUNCTION(EncodedJSValue, op_call_NotJSFunction)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
     
@@ -2378,6 +3918,7 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_create_arguments)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
 
+    COUNT_STUB_EVENT("arguments objects materialized");
     Arguments* arguments = Arguments::create(*stackFrame.globalData, stackFrame.callFrame);
     return JSValue::encode(JSValue(arguments));
 }
@@ -2387,6 +3928,7 @@ DEFINE_STUB_FUNCTION(void, op_tear_off_activation)
     STUB_INIT_STACK_FRAME(stackFrame);
 
     ASSERT(stackFrame.callFrame->codeBlock()->needsFullScopeChain());
+    COUNT_STUB_EVENT("activations torn off");
     jsCast<JSActivation*>(stackFrame.args[0].jsValue())->tearOff(*stackFrame.globalData);
 }
 
@@ -2456,6 +3998,7 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_resolve)
 
     CallFrame* callFrame = stackFrame.callFrame;
 
+    COUNT_STUB_EVENT("resolve slow path");
     JSValue result = JSScope::resolve(callFrame, stackFrame.args[0].identifier(), stackFrame.args[1].resolveOperations());
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(result);
@@ -2468,13 +4011,14 @@ DEFINE_STUB_FUNCTION(void, op_put_to_base)
     CallFrame* callFrame = stackFrame.callFrame;
     JSValue base = callFrame->r(stackFrame.args[0].int32()).jsValue();
     JSValue value = callFrame->r(stackFrame.args[2].int32()).jsValue();
+    COUNT_STUB_EVENT("put_to_base slow path");
     JSScope::resolvePut(callFrame, base, stackFrame.args[1].identifier(), value, stackFrame.args[3].putToBaseOperation());
     CHECK_FOR_EXCEPTION_AT_END();
 }
 
 DEFINE_STUB_FUNCTION(EncodedJSValue, op_construct_NotJSConstruct)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
     JSValue callee = callFrame->calleeAsValue();
@@ -2500,12 +4044,199 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_construct_NotJSConstruct)
     return returnValue;
 }
 
+// Typed arrays intercept indexed access, so the JIT never specializes get_by_val/put_by_val for
+// them and every element access reaches the generic stubs. The embedder registers where each
+// kind of typed array keeps its storage and length, which is enough to index it here without
+// going through getOwnPropertySlotByIndex() and putByIndex().
+static const TypedArrayDescriptor* typedArrayDescriptorFor(JSGlobalData& globalData, JSCell* cell)
+{
+    const ClassInfo* classInfo = cell->classInfo();
+    const TypedArrayDescriptor* descriptor;
+    switch (classInfo->typedArrayStorageType) {
+    case TypedArrayInt8:
+        descriptor = &globalData.int8ArrayDescriptor();
+        break;
+    case TypedArrayInt16:
+        descriptor = &globalData.int16ArrayDescriptor();
+        break;
+    case TypedArrayInt32:
+        descriptor = &globalData.int32ArrayDescriptor();
+        break;
+    case TypedArrayUint8:
+        descriptor = &globalData.uint8ArrayDescriptor();
+        break;
+    case TypedArrayUint8Clamped:
+        descriptor = &globalData.uint8ClampedArrayDescriptor();
+        break;
+    case TypedArrayUint16:
+        descriptor = &globalData.uint16ArrayDescriptor();
+        break;
+    case TypedArrayUint32:
+        descriptor = &globalData.uint32ArrayDescriptor();
+        break;
+    case TypedArrayFloat32:
+        descriptor = &globalData.float32ArrayDescriptor();
+        break;
+    case TypedArrayFloat64:
+        descriptor = &globalData.float64ArrayDescriptor();
+        break;
+    default:
+        return 0;
+    }
+    return descriptor->m_classInfo == classInfo ? descriptor : 0;
+}
+
+static inline void* typedArrayStorage(JSCell* cell, const TypedArrayDescriptor& descriptor, uint32_t index)
+{
+    // A neutered array reports a length of 0, so the bounds check covers it as well.
+    uint32_t length = *reinterpret_cast<uint32_t*>(reinterpret_cast<char*>(cell) + descriptor.m_lengthOffset);
+    if (index >= length)
+        return 0;
+    return *reinterpret_cast<void**>(reinterpret_cast<char*>(cell) + descriptor.m_storageOffset);
+}
+
+static inline JSValue jsTypedArrayDouble(double value)
+{
+    // Element storage may hold any NaN bit pattern; only the canonical one is a valid JSValue.
+    return jsNumber(value == value ? value : std::numeric_limits<double>::quiet_NaN());
+}
+
+static bool tryGetTypedArrayIndex(JSGlobalData& globalData, JSCell* cell, uint32_t index, JSValue& result)
+{
+    const TypedArrayDescriptor* descriptor = typedArrayDescriptorFor(globalData, cell);
+    if (!descriptor)
+        return false;
+    void* storage = typedArrayStorage(cell, *descriptor, index);
+    if (!storage)
+        return false;
+
+    switch (cell->classInfo()->typedArrayStorageType) {
+    case TypedArrayInt8:
+        result = jsNumber(static_cast<int8_t*>(storage)[index]);
+        return true;
+    case TypedArrayInt16:
+        result = jsNumber(static_cast<int16_t*>(storage)[index]);
+        return true;
+    case TypedArrayInt32:
+        result = jsNumber(static_cast<int32_t*>(storage)[index]);
+        return true;
+    case TypedArrayUint8:
+    case TypedArrayUint8Clamped:
+        result = jsNumber(static_cast<uint8_t*>(storage)[index]);
+        return true;
+    case TypedArrayUint16:
+        result = jsNumber(static_cast<uint16_t*>(storage)[index]);
+        return true;
+    case TypedArrayUint32:
+        result = jsNumber(static_cast<uint32_t*>(storage)[index]);
+        return true;
+    case TypedArrayFloat32:
+        result = jsTypedArrayDouble(static_cast<float*>(storage)[index]);
+        return true;
+    case TypedArrayFloat64:
+        result = jsTypedArrayDouble(static_cast<double*>(storage)[index]);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static inline uint8_t clampToUint8(JSValue value)
+{
+    if (value.isInt32())
+        return static_cast<uint8_t>(std::min(std::max(value.asInt32(), 0), 255));
+    double number = value.asDouble();
+    if (!(number > 0))
+        return 0;
+    if (number >= 255)
+        return 255;
+    // Round half to even, as Uint8ClampedArray requires. Compare against floor + 0.5 rather
+    // than flooring number + 0.5, which rounds the double just below 0.5 up to 1.
+    double floored = floor(number);
+    double half = floored + 0.5;
+    if (number < half)
+        return static_cast<uint8_t>(floored);
+    if (number > half)
+        return static_cast<uint8_t>(floored + 1);
+    return static_cast<uint8_t>(fmod(floored, 2) ? floored + 1 : floored);
+}
+
+// Only numbers are stored here; anything else needs ToNumber(), which may run user code.
+static bool tryPutTypedArrayIndex(JSGlobalData& globalData, JSCell* cell, uint32_t index, JSValue value)
+{
+    if (!value.isNumber())
+        return false;
+    const TypedArrayDescriptor* descriptor = typedArrayDescriptorFor(globalData, cell);
+    if (!descriptor)
+        return false;
+    void* storage = typedArrayStorage(cell, *descriptor, index);
+    if (!storage)
+        return false;
+
+    TypedArrayType type = cell->classInfo()->typedArrayStorageType;
+    if (type == TypedArrayFloat32) {
+        static_cast<float*>(storage)[index] = static_cast<float>(value.asNumber());
+        return true;
+    }
+    if (type == TypedArrayFloat64) {
+        static_cast<double*>(storage)[index] = value.asNumber();
+        return true;
+    }
+    if (type == TypedArrayUint8Clamped) {
+        static_cast<uint8_t*>(storage)[index] = clampToUint8(value);
+        return true;
+    }
+
+    int32_t integer = value.isInt32() ? value.asInt32() : toInt32(value.asDouble());
+    switch (type) {
+    case TypedArrayInt8:
+        static_cast<int8_t*>(storage)[index] = static_cast<int8_t>(integer);
+        return true;
+    case TypedArrayInt16:
+        static_cast<int16_t*>(storage)[index] = static_cast<int16_t>(integer);
+        return true;
+    case TypedArrayInt32:
+        static_cast<int32_t*>(storage)[index] = integer;
+        return true;
+    case TypedArrayUint8:
+        static_cast<uint8_t*>(storage)[index] = static_cast<uint8_t>(integer);
+        return true;
+    case TypedArrayUint16:
+        static_cast<uint16_t*>(storage)[index] = static_cast<uint16_t>(integer);
+        return true;
+    case TypedArrayUint32:
+        static_cast<uint32_t*>(storage)[index] = static_cast<uint32_t>(integer);
+        return true;
+    default:
+        return false;
+    }
+}
+
 static JSValue getByVal(
     CallFrame* callFrame, JSValue baseValue, JSValue subscript, ReturnAddressPtr returnAddress)
 {
     if (LIKELY(baseValue.isCell() && subscript.isString())) {
-        if (JSValue result = baseValue.asCell()->fastGetOwnProperty(callFrame, asString(subscript)->value(callFrame)))
+        const String& name = asString(subscript)->value(callFrame);
+        ByValStringCache& cache = vmStubCaches(callFrame->globalData()).byValString;
+        JSValue result;
+        if (name.impl() && cache.tryGet(baseValue.asCell(), name.impl(), result))
             return result;
+
+        // Entries are keyed by the atomized name, so only subscripts that are themselves
+        // identifiers (string constants, property names) can hit later. Other keys, such as
+        // those from split() or JSON, are answered here without being atomized.
+        if ((result = baseValue.asCell()->fastGetOwnProperty(callFrame, name))) {
+            if (name.impl()->isIdentifier())
+                cache.addOwnGet(callFrame->globalData(), baseValue.asCell(), name);
+            return result;
+        }
+
+        Identifier property(callFrame, name);
+        PropertySlot slot(baseValue);
+        result = baseValue.get(callFrame, property, slot);
+        if (!callFrame->hadException())
+            cache.addGet(baseValue, property.impl(), slot);
+        return result;
     }
 
     if (subscript.isUInt32()) {
@@ -2514,6 +4245,9 @@ static JSValue getByVal(
             ctiPatchCallByReturnAddress(callFrame->codeBlock(), returnAddress, FunctionPtr(cti_op_get_by_val_string));
             return asString(baseValue)->getIndex(callFrame, i);
         }
+        JSValue result;
+        if (baseValue.isCell() && tryGetTypedArrayIndex(callFrame->globalData(), baseValue.asCell(), i, result))
+            return result;
         return baseValue.get(callFrame, i);
     }
 
@@ -2624,11 +4358,15 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_sub)
     JSValue src1 = stackFrame.args[0].jsValue();
     JSValue src2 = stackFrame.args[1].jsValue();
 
-    if (src1.isNumber() && src2.isNumber())
-        return JSValue::encode(jsNumber(src1.asNumber() - src2.asNumber()));
+    if (src1.isNumber() && src2.isNumber()) {
+        JSValue result = jsNumber(src1.asNumber() - src2.asNumber());
+        RECORD_ARITHMETIC("sub", src1, src2, result);
+        return JSValue::encode(result);
+    }
 
     CallFrame* callFrame = stackFrame.callFrame;
     JSValue result = jsNumber(src1.toNumber(callFrame) - src2.toNumber(callFrame));
+    RECORD_ARITHMETIC("sub", src1, src2, result);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(result);
 }
@@ -2641,7 +4379,7 @@ static void putByVal(CallFrame* callFrame, JSValue baseValue, JSValue subscript,
             JSObject* object = asObject(baseValue);
             if (object->canSetIndexQuickly(i))
                 object->setIndexQuickly(callFrame->globalData(), i, value);
-            else
+            else if (!tryPutTypedArrayIndex(callFrame->globalData(), object, i, value))
                 object->methodTable()->putByIndex(object, callFrame, i, value, callFrame->codeBlock()->isStrictMode());
         } else
             baseValue.putByIndex(callFrame, i, value, callFrame->codeBlock()->isStrictMode());
@@ -2649,10 +4387,17 @@ static void putByVal(CallFrame* callFrame, JSValue baseValue, JSValue subscript,
         PutPropertySlot slot(callFrame->codeBlock()->isStrictMode());
         baseValue.put(callFrame, jsCast<NameInstance*>(subscript.asCell())->privateName(), value, slot);
     } else {
+        if (subscript.isString() && baseValue.isCell()) {
+            const String& name = asString(subscript)->value(callFrame);
+            if (name.impl() && vmStubCaches(callFrame->globalData()).byValString.tryPut(callFrame->globalData(), baseValue.asCell(), name.impl(), value))
+                return;
+        }
         Identifier property(callFrame, subscript.toString(callFrame)->value(callFrame));
         if (!callFrame->globalData().exception) { // Don't put to an object if toString threw an exception.
             PutPropertySlot slot(callFrame->codeBlock()->isStrictMode());
             baseValue.put(callFrame, property, value, slot);
+            if (subscript.isString() && !callFrame->globalData().exception)
+                vmStubCaches(callFrame->globalData()).byValString.addPut(baseValue, property.impl(), slot);
         }
     }
 }
@@ -2771,6 +4516,15 @@ DEFINE_STUB_FUNCTION(void*, op_load_varargs)
     JSValue arguments = stackFrame.args[1].jsValue();
     int firstFreeRegister = stackFrame.args[2].int32();
 
+    // An empty value means f.apply(x, arguments) with arguments never materialized, which
+    // loadVarargs copies straight out of the caller's frame.
+    if (!arguments)
+        COUNT_STUB_EVENT("load_varargs from unmaterialized arguments");
+    else if (arguments.inherits(&Arguments::s_info))
+        COUNT_STUB_EVENT("load_varargs from Arguments object");
+    else
+        COUNT_STUB_EVENT("load_varargs from other object");
+
     CallFrame* newCallFrame = loadVarargs(callFrame, stack, thisValue, arguments, firstFreeRegister);
     if (!newCallFrame)
         VM_THROW_EXCEPTION();
@@ -2783,11 +4537,15 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_negate)
 
     JSValue src = stackFrame.args[0].jsValue();
 
-    if (src.isNumber())
-        return JSValue::encode(jsNumber(-src.asNumber()));
+    if (src.isNumber()) {
+        JSValue result = jsNumber(-src.asNumber());
+        RECORD_ARITHMETIC("negate", src, JSValue(), result);
+        return JSValue::encode(result);
+    }
 
     CallFrame* callFrame = stackFrame.callFrame;
     JSValue result = jsNumber(-src.toNumber(callFrame));
+    RECORD_ARITHMETIC("negate", src, JSValue(), result);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(result);
 }
@@ -2830,11 +4588,15 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_div)
     JSValue src1 = stackFrame.args[0].jsValue();
     JSValue src2 = stackFrame.args[1].jsValue();
 
-    if (src1.isNumber() && src2.isNumber())
-        return JSValue::encode(jsNumber(src1.asNumber() / src2.asNumber()));
+    if (src1.isNumber() && src2.isNumber()) {
+        JSValue result = jsNumber(src1.asNumber() / src2.asNumber());
+        RECORD_ARITHMETIC("div", src1, src2, result);
+        return JSValue::encode(result);
+    }
 
     CallFrame* callFrame = stackFrame.callFrame;
     JSValue result = jsNumber(src1.toNumber(callFrame) / src2.toNumber(callFrame));
+    RECORD_ARITHMETIC("div", src1, src2, result);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(result);
 }
@@ -3038,6 +4800,29 @@ DEFINE_STUB_FUNCTION(int, op_eq)
 #endif // USE(JSVALUE32_64)
 }
 
+// Most string comparisons reaching the stubs are against constants, which are atomic. Two
+// distinct atoms are never equal, and strings whose hashes are already known can usually be
+// told apart without looking at their characters.
+static ALWAYS_INLINE bool jsStringEqual(CallFrame* callFrame, JSString* string1, JSString* string2)
+{
+    if (string1 == string2)
+        return true;
+    if (string1->length() != string2->length())
+        return false;
+    if (!string1->isRope() && !string2->isRope()) {
+        StringImpl* impl1 = string1->tryGetValue().impl();
+        StringImpl* impl2 = string2->tryGetValue().impl();
+        if (impl1 == impl2)
+            return true;
+        if (impl1->isAtomic() && impl2->isAtomic())
+            return false;
+        if (impl1->hasHash() && impl2->hasHash() && impl1->existingHash() != impl2->existingHash())
+            return false;
+        return equal(impl1, impl2);
+    }
+    return string1->value(callFrame) == string2->value(callFrame);
+}
+
 DEFINE_STUB_FUNCTION(int, op_eq_strings)
 {
 #if USE(JSVALUE32_64)
@@ -3048,7 +4833,7 @@ DEFINE_STUB_FUNCTION(int, op_eq_strings)
 
     ASSERT(string1->isString());
     ASSERT(string2->isString());
-    return string1->value(stackFrame.callFrame) == string2->value(stackFrame.callFrame);
+    return jsStringEqual(stackFrame.callFrame, string1, string2);
 #else
     UNUSED_PARAM(args);
     RELEASE_ASSERT_NOT_REACHED();
@@ -3139,6 +4924,7 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_mod)
     CallFrame* callFrame = stackFrame.callFrame;
     double d = dividendValue.toNumber(callFrame);
     JSValue result = jsNumber(fmod(d, divisorValue.toNumber(callFrame)));
+    RECORD_ARITHMETIC("mod", dividendValue, divisorValue, result);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(result);
 }
@@ -3197,6 +4983,18 @@ DEFINE_STUB_FUNCTION(JSObject*, op_new_regexp)
         VM_THROW_EXCEPTION();
     }
 
+#if ENABLE(SAMPLING_COUNTERS)
+    // The RegExp is shared through the JSGlobalData's RegExpCache, so any literal with the same
+    // pattern and flags that has already run reuses its matcher. Each literal is counted on its
+    // first evaluation only; a literal in a loop would otherwise count every iteration.
+    if (vmStubCaches(*stackFrame.globalData).countedRegExpLiterals.add(make_pair(callFrame->codeBlock(), regExp)).isNewEntry) {
+        if (regExp->hasCode())
+            COUNT_STUB_EVENT("regexp literals finding their matcher compiled");
+        else
+            COUNT_STUB_EVENT("regexp literals finding no compiled matcher");
+    }
+#endif
+
     return RegExpObject::create(*stackFrame.globalData, stackFrame.callFrame->lexicalGlobalObject(), stackFrame.callFrame->lexicalGlobalObject()->regExpStructure(), regExp);
 }
 
@@ -3214,9 +5012,67 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_bitor)
     return JSValue::encode(result);
 }
 
+// Does what eval() does, except that strings which are evaluated repeatedly are compiled once
+// and looked up in the VM's EvalExecutableCache.
+static JSValue evalWithCache(CallFrame* callFrame)
+{
+    if (!callFrame->argumentCount())
+        return jsUndefined();
+
+    JSValue program = callFrame->argument(0);
+    if (!program.isString())
+        return program;
+
+    TopCallFrameSetter topCallFrame(callFrame->globalData(), callFrame);
+    String programSource = asString(program)->value(callFrame);
+    if (callFrame->hadException())
+        return JSValue();
+
+    CallFrame* callerFrame = callFrame->callerFrame();
+    CodeBlock* callerCodeBlock = callerFrame->codeBlock();
+    JSScope* callerScope = callerFrame->scope();
+    if (!EvalExecutableCache::canCache(programSource, callerScope))
+        return eval(callFrame);
+
+    bool isStrict = callerCodeBlock->isStrictMode();
+    EvalExecutable* executable;
+    if (EvalExecutableCache::evalCodeCacheMayTake(isStrict, programSource)) {
+        // The CodeBlock's own EvalCodeCache serves these, so they never take a slot here.
+        executable = callerCodeBlock->evalCodeCache().tryGet(isStrict, programSource, callerScope);
+        if (!executable) {
+            COUNT_STUB_EVENT("eval code cache misses (deferred to eval)");
+            return eval(callFrame);
+        }
+        COUNT_STUB_EVENT("eval code cache hits (EvalCodeCache)");
+        return callFrame->globalData().interpreter->execute(executable, callFrame, callerFrame->thisValue(), callerScope);
+    }
+
+    ScriptExecutable* owner = callerCodeBlock->ownerExecutable();
+    EvalExecutableCache& cache = vmStubCaches(callFrame->globalData()).evalCode;
+    bool seenBefore;
+    executable = cache.get(owner, isStrict, programSource, callerScope, seenBefore);
+    if (executable)
+        COUNT_STUB_EVENT("eval code cache hits (side cache)");
+    else {
+        // Only strings seen twice are compiled for the cache; eval() handles one-off strings.
+        if (!seenBefore) {
+            COUNT_STUB_EVENT("eval code cache misses (deferred to eval)");
+            return eval(callFrame);
+        }
+
+        COUNT_STUB_EVENT("eval code cache misses (compiled)");
+        executable = EvalExecutable::create(callFrame, makeSource(programSource), isStrict);
+        if (JSObject* error = executable->compile(callFrame, callerScope))
+            return throwError(callFrame, error);
+        cache.add(callFrame->globalData(), owner, isStrict, programSource, callerScope, executable);
+    }
+
+    return callFrame->globalData().interpreter->execute(executable, callFrame, callerFrame->thisValue(), callerScope);
+}
+
 DEFINE_STUB_FUNCTION(EncodedJSValue, op_call_eval)
 {
-    STUB_INIT_STACK_FRAME(stackFrame);
+    STUB_INIT_CALLEE_STACK_FRAME(stackFrame);
 
     CallFrame* callFrame = stackFrame.callFrame;
     CallFrame* callerFrame = callFrame->callerFrame();
@@ -3231,17 +5087,33 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_call_eval)
     if (!isHostFunction(callFrame->calleeAsValue(), globalFuncEval))
         return JSValue::encode(JSValue());
 
-    JSValue result = eval(callFrame);
+    JSValue result = evalWithCache(callFrame);
     if (stackFrame.globalData->exception)
         return throwExceptionFromOpCall<EncodedJSValue>(stackFrame, callFrame, STUB_RETURN_ADDRESS);
 
     return JSValue::encode(result);
 }
 
+static inline void countThrow(CallFrame* throwFrame, CallFrame* handlerFrame)
+{
+#if ENABLE(SAMPLING_COUNTERS)
+    // Unwinding costs a handler search and a tear-off per frame, so deep throws are what hurt.
+    unsigned frames = 0;
+    for (CallFrame* frame = throwFrame; frame && frame != handlerFrame; frame = frame->callerFrame()->removeHostCallFrameFlag())
+        ++frames;
+    COUNT_STUB_EVENT("exceptions thrown");
+    COUNT_STUB_EVENTS("call frames unwound by exceptions", frames);
+#else
+    UNUSED_PARAM(throwFrame);
+    UNUSED_PARAM(handlerFrame);
+#endif
+}
+
 DEFINE_STUB_FUNCTION(void*, op_throw)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
     ExceptionHandler handler = jitThrow(stackFrame.globalData, stackFrame.callFrame, stackFrame.args[0].jsValue(), STUB_RETURN_ADDRESS);
+    countThrow(stackFrame.callFrame, handler.callFrame);
     STUB_SET_RETURN_ADDRESS(handler.catchRoutine);
     return handler.callFrame;
 }
@@ -3263,9 +5135,21 @@ DEFINE_STUB_FUNCTION(int, has_property)
 {
     STUB_INIT_STACK_FRAME(stackFrame);
 
+    CallFrame* callFrame = stackFrame.callFrame;
     JSObject* base = stackFrame.args[0].jsObject();
     JSString* property = stackFrame.args[1].jsString();
-    int result = base->hasProperty(stackFrame.callFrame, Identifier(stackFrame.callFrame, property->value(stackFrame.callFrame)));
+    // Names handed out by JSPropertyNameIterator are already identifiers, so this does not atomize.
+    Identifier propertyName(callFrame, property->value(callFrame));
+    CHECK_FOR_EXCEPTION();
+
+    // Most names seen here are still own properties of the object being enumerated. For plain
+    // objects, including dictionaries, the structure's property table answers that without
+    // going through getOwnPropertySlot.
+    Structure* structure = base->structure();
+    if (!structure->typeInfo().overridesGetOwnPropertySlot() && isValidOffset(structure->get(callFrame->globalData(), propertyName)))
+        return true;
+
+    int result = base->hasProperty(callFrame, propertyName);
     CHECK_FOR_EXCEPTION_AT_END();
     return result;
 }
@@ -3314,7 +5198,11 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_stricteq)
     JSValue src1 = stackFrame.args[0].jsValue();
     JSValue src2 = stackFrame.args[1].jsValue();
     
-    bool result = JSValue::strictEqual(stackFrame.callFrame, src1, src2);
+    bool result;
+    if (isJSString(src1) && isJSString(src2))
+        result = jsStringEqual(stackFrame.callFrame, asString(src1), asString(src2));
+    else
+        result = JSValue::strictEqual(stackFrame.callFrame, src1, src2);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(jsBoolean(result));
 }
@@ -3342,7 +5230,11 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_nstricteq)
     JSValue src1 = stackFrame.args[0].jsValue();
     JSValue src2 = stackFrame.args[1].jsValue();
 
-    bool result = !JSValue::strictEqual(stackFrame.callFrame, src1, src2);
+    bool result;
+    if (isJSString(src1) && isJSString(src2))
+        result = !jsStringEqual(stackFrame.callFrame, asString(src1), asString(src2));
+    else
+        result = !JSValue::strictEqual(stackFrame.callFrame, src1, src2);
     CHECK_FOR_EXCEPTION_AT_END();
     return JSValue::encode(jsBoolean(result));
 }
@@ -3375,15 +5267,30 @@ DEFINE_STUB_FUNCTION(EncodedJSValue, op_in)
     JSObject* baseObj = asObject(baseVal);
 
     uint32_t i;
-    if (propName.getUInt32(i))
+    if (propName.getUInt32(i)) {
+        if (baseObj->canGetIndexQuickly(i))
+            return JSValue::encode(jsBoolean(true));
         return JSValue::encode(jsBoolean(baseObj->hasProperty(callFrame, i)));
+    }
 
     if (isName(propName))
         return JSValue::encode(jsBoolean(baseObj->hasProperty(callFrame, jsCast<NameInstance*>(propName.asCell())->privateName())));
 
+    InCache& cache = vmStubCaches(callFrame->globalData()).in;
+    bool result;
+    if (propName.isString()) {
+        // Keys are usually string constants, which are already atomic and hit without
+        // building an Identifier.
+        const String& name = asString(propName)->value(callFrame);
+        if (name.impl() && cache.tryGet(baseObj->structure(), name.impl(), result))
+            return JSValue::encode(jsBoolean(result));
+    }
+
     Identifier property(callFrame, propName.toString(callFrame)->value(callFrame));
     CHECK_FOR_EXCEPTION();
-    return JSValue::encode(jsBoolean(baseObj->hasProperty(callFrame, property)));
+    if (!cache.lookup(callFrame, baseObj, property, result))
+        result = baseObj->hasProperty(callFrame, property);
+    return JSValue::encode(jsBoolean(result));
 }
 
 DEFINE_STUB_FUNCTION(void, op_push_name_scope)
@@ -3471,7 +5378,10 @@ DEFINE_STUB_FUNCTION(void*, op_switch_string)
 
     if (scrutinee.isString()) {
         StringImpl* value = asString(scrutinee)->value(callFrame).impl();
-        result = codeBlock->stringSwitchJumpTable(tableIndex).ctiForValue(value).executableAddress();
+        if (value) {
+            StringJumpTable& table = codeBlock->stringSwitchJumpTable(tableIndex);
+            result = vmStubCaches(callFrame->globalData()).stringSwitch.targetFor(codeBlock, table, value);
+        }
     }
 
     CHECK_FOR_EXCEPTION_AT_END();
@@ -3564,6 +5474,7 @@ DEFINE_STUB_FUNCTION(void*, vm_throw)
     STUB_INIT_STACK_FRAME(stackFrame);
     JSGlobalData* globalData = stackFrame.globalData;
     ExceptionHandler handler = jitThrow(globalData, stackFrame.callFrame, globalData->exception, globalData->exceptionLocation);
+    countThrow(stackFrame.callFrame, handler.callFrame);
     STUB_SET_RETURN_ADDRESS(handler.catchRoutine);
     return handler.callFrame;
 }
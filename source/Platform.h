@@ -865,6 +865,25 @@
 #define ENABLE_WRITE_BARRIER_PROFILING 0
 #endif
 
+/* Counts calls to each JIT stub function and times a sample of them, with
+   per-bytecode attribution. The sorted table is dumped at exit. */
+#if !defined(ENABLE_JIT_STUB_PROFILING)
+#define ENABLE_JIT_STUB_PROFILING 0
+#endif
+
+/* Records the operand and result types seen by the baseline JIT's arithmetic
+   slow paths, per bytecode. The profiles are dumped at exit. */
+#if !defined(ENABLE_ARITHMETIC_PROFILING)
+#define ENABLE_ARITHMETIC_PROFILING 0
+#endif
+
+/* When non-zero, the JIT throws away the code of functions that are not
+   running whenever its committed executable memory grows past this many
+   bytes. Usage statistics are dumped at exit. */
+#if !defined(JIT_EXECUTABLE_MEMORY_BUDGET)
+#define JIT_EXECUTABLE_MEMORY_BUDGET 0
+#endif
+
 /* Configure the JIT */
 #if CPU(X86) && COMPILER(MSVC)
 #define JSC_HOST_CALL __fastcall
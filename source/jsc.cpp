@@ -46,6 +46,7 @@
 #include <wtf/CurrentTime.h>
 #include <wtf/MainThread.h>
 #include <wtf/StringPrintStream.h>
+#include <wtf/Threading.h>
 #include <wtf/text/StringBuilder.h>
 
 #if !OS(WINDOWS)
@@ -85,6 +86,16 @@
 #include <arm/arch.h>
 #endif
 
+#if ENABLE(JIT)
+namespace JSC {
+// The sampling profiler lives with the JIT stubs, which take the samples.
+void startStubSamplingProfiler(JSGlobalData&, double intervalInSeconds);
+bool stopStubSamplingProfiler(JSGlobalData&, const char* foldedStacksPath);
+// Asks the JIT to poll the terminator flag often rather than at the TimeoutChecker's pace.
+void setFrequentTimeoutChecks(JSGlobalData&, bool);
+}
+#endif
+
 using namespace JSC;
 using namespace WTF;
 
@@ -130,6 +141,8 @@ public:
         , m_dump(false)
         , m_exitCode(false)
         , m_profile(false)
+        , m_watchdogMilliseconds(0)
+        , m_sampleIntervalMicroseconds(1000)
     {
         parseArguments(argc, argv);
     }
@@ -141,6 +154,9 @@ public:
     Vector<String> m_arguments;
     bool m_profile;
     String m_profilerOutput;
+    unsigned m_watchdogMilliseconds;
+    String m_sampleProfileOutput;
+    unsigned m_sampleIntervalMicroseconds;
 
     void parseArguments(int, char**);
 };
@@ -173,6 +189,68 @@ long StopWatch::getElapsedMS()
     return static_cast<long>((m_stopTime - m_startTime) * 1000);
 }
 
+// Terminates the running script from a background thread once its time is up. Script code
+// only has to look at the JSGlobalData's terminator flag, which it already checks whenever
+// the timeout check runs. While a watchdog is armed the JIT is asked to run that check every
+// few loop iterations; the check sits on loop back edges, so code that never loops (such as
+// deep straight-line recursion) is not interrupted until it returns to a loop.
+class Watchdog {
+    WTF_MAKE_NONCOPYABLE(Watchdog);
+public:
+    Watchdog(JSGlobalData*, unsigned milliseconds);
+    void stop();
+    bool didFire() const { return m_didFire; }
+
+private:
+    static void threadMain(void*);
+
+    JSGlobalData* m_globalData;
+    double m_deadline;
+    Mutex m_lock;
+    ThreadCondition m_condition;
+    bool m_stopped;
+    bool m_didFire;
+    ThreadIdentifier m_thread;
+};
+
+Watchdog::Watchdog(JSGlobalData* globalData, unsigned milliseconds)
+    : m_globalData(globalData)
+    , m_deadline(currentTime() + milliseconds / 1000.0)
+    , m_stopped(false)
+    , m_didFire(false)
+{
+#if ENABLE(JIT)
+    setFrequentTimeoutChecks(*globalData, true);
+#endif
+    m_thread = createThread(threadMain, this, "jsc watchdog");
+}
+
+void Watchdog::stop()
+{
+    {
+        MutexLocker locker(m_lock);
+        m_stopped = true;
+        m_condition.signal();
+    }
+    waitForThreadCompletion(m_thread);
+#if ENABLE(JIT)
+    setFrequentTimeoutChecks(*m_globalData, false);
+#endif
+}
+
+void Watchdog::threadMain(void* context)
+{
+    Watchdog* watchdog = static_cast<Watchdog*>(context);
+    MutexLocker locker(watchdog->m_lock);
+    while (!watchdog->m_stopped) {
+        if (!watchdog->m_condition.timedWait(watchdog->m_lock, watchdog->m_deadline) && currentTime() >= watchdog->m_deadline) {
+            watchdog->m_didFire = true;
+            watchdog->m_globalData->terminator.terminateSoon();
+            return;
+        }
+    }
+}
+
 class GlobalObject : public JSGlobalObject {
 private:
     GlobalObject(JSGlobalData&, Structure*);
@@ -660,6 +738,12 @@ static NO_RETURN void printUsageStatement(bool help = false)
     fprintf(stderr, "  -p <file>  Outputs profiling data to a file\n");
     fprintf(stderr, "  -x         Output exit code before terminating\n");
     fprintf(stderr, "\n");
+    fprintf(stderr, "  --watchdog-ms=<ms>         Terminates script execution after <ms> milliseconds\n");
+    fprintf(stderr, "                             (checked in loops; code that never loops is not interrupted)\n");
+#if ENABLE(JIT)
+    fprintf(stderr, "  --sample-profile=<file>    Writes sampled JIT call stacks to <file> in folded form\n");
+    fprintf(stderr, "  --sample-interval-us=<us>  Sets the sampling interval (default 1000)\n");
+#endif
     fprintf(stderr, "  --options                  Dumps all JSC VM options and exits\n");
     fprintf(stderr, "  --dumpOptions              Dumps all JSC VM options before continuing\n");
     fprintf(stderr, "  --<jsc VM option>=<value>  Sets the specified JSC VM option\n");
@@ -732,6 +816,26 @@ void CommandLine::parseArguments(int argc, char** argv)
             needToDumpOptions = true;
             continue;
         }
+        if (!strncmp(arg, "--watchdog-ms=", 14)) {
+            m_watchdogMilliseconds = atoi(&arg[14]);
+            if (!m_watchdogMilliseconds)
+                printUsageStatement();
+            continue;
+        }
+#if ENABLE(JIT)
+        if (!strncmp(arg, "--sample-profile=", 17)) {
+            m_sampleProfileOutput = &arg[17];
+            if (m_sampleProfileOutput.isEmpty())
+                printUsageStatement();
+            continue;
+        }
+        if (!strncmp(arg, "--sample-interval-us=", 21)) {
+            m_sampleIntervalMicroseconds = atoi(&arg[21]);
+            if (!m_sampleIntervalMicroseconds)
+                printUsageStatement();
+            continue;
+        }
+#endif
 
         // See if the -- option is a JSC VM option.
         // NOTE: At this point, we know that the arg starts with "--". Skip it.
@@ -770,7 +874,31 @@ int jscmain(int argc, char** argv)
         globalData->m_perBytecodeProfiler = adoptPtr(new Profiler::Database(*globalData));
     
     GlobalObject* globalObject = GlobalObject::create(*globalData, GlobalObject::createStructure(*globalData, jsNull()), options.m_arguments);
+
+    OwnPtr<Watchdog> watchdog;
+    if (options.m_watchdogMilliseconds)
+        watchdog = adoptPtr(new Watchdog(globalData.get(), options.m_watchdogMilliseconds));
+
+#if ENABLE(JIT)
+    if (!options.m_sampleProfileOutput.isEmpty())
+        startStubSamplingProfiler(*globalData, options.m_sampleIntervalMicroseconds / 1000000.0);
+#endif
+
     bool success = runWithScripts(globalObject, options.m_scripts, options.m_dump);
+
+#if ENABLE(JIT)
+    if (!options.m_sampleProfileOutput.isEmpty() && !stopStubSamplingProfiler(*globalData, options.m_sampleProfileOutput.utf8().data()))
+        fprintf(stderr, "could not save sampling profiler output.\n");
+#endif
+
+    if (watchdog) {
+        watchdog->stop();
+        if (watchdog->didFire()) {
+            fprintf(stderr, "Watchdog terminated execution after %u ms\n", options.m_watchdogMilliseconds);
+            success = false;
+        }
+    }
+
     if (options.m_interactive && success)
         runInteractive(globalObject);
 
@@ -0,0 +1,50 @@
+// Times string switches with 4 to 256 cases in the jsc shell:
+//
+//     jsc switch-string-benchmark.js
+//
+// Each size runs one switch on its own, then several switches at once, so that tables which
+// land in the same set of op_switch_string's dispatch cache are exercised too.
+
+var iterations = 2000000;
+
+function caseName(i)
+{
+    return "message" + i + String.fromCharCode(97 + i % 26);
+}
+
+function makeDispatcher(size, salt)
+{
+    var source = "var hits = 0; for (var i = 0; i < keys.length; ++i) { switch (keys[i]) {";
+    for (var i = 0; i < size; ++i)
+        source += "case '" + caseName(i) + "': hits += " + (i + salt) + "; break;";
+    source += "default: hits -= 1; } } return hits;";
+    return new Function("keys", source);
+}
+
+function makeKeys(size)
+{
+    // One key in eight misses every case, so the default target is measured too.
+    var keys = [];
+    for (var i = 0; i < 64; ++i)
+        keys.push(i % 8 ? caseName((i * 7) % size) : "unknown" + i);
+    return keys;
+}
+
+function run(dispatchers, keys)
+{
+    var result = 0;
+    var start = preciseTime();
+    for (var n = 0; n < iterations / keys.length; ++n)
+        result += dispatchers[n % dispatchers.length](keys);
+    return { ms: (preciseTime() - start) * 1000, result: result };
+}
+
+for (var size = 4; size <= 256; size *= 2) {
+    var keys = makeKeys(size);
+    var single = run([makeDispatcher(size, 0)], keys);
+    var many = [];
+    for (var j = 0; j < 8; ++j)
+        many.push(makeDispatcher(size, j));
+    var interleaved = run(many, keys);
+    print(size + " cases: " + single.ms.toFixed(1) + " ms alone, " + interleaved.ms.toFixed(1) + " ms across 8 switches");
+}